@@ -0,0 +1,330 @@
+#include "aic3101_i2s.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "driver/i2s_std.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char TAG[] = "i2s-codec";
+
+// DMA 描述符数量, 发送端稳定时整个环都是待播放的数据, 接收端读走一块
+// 往返延迟约为 (描述符数 + 1) 块
+#define I2S_DMA_DESC_NUM 3
+#define I2S_MIN_FRAMES   32
+#define I2S_MAX_BLOCK_BYTES 4092
+
+// 延迟测量的脉冲幅度和检测门限 (16 位满幅的比例)
+#define LATENCY_IMPULSE   0x6000
+#define LATENCY_THRESHOLD 0x1800
+
+typedef enum {
+    PROBE_IDLE,
+    PROBE_ARMED,        // 下一块输出中放入脉冲
+    PROBE_WAITING,      // 在输入中寻找脉冲
+} latency_probe_t;
+
+typedef struct {
+    i2s_chan_handle_t tx;
+    i2s_chan_handle_t rx;
+    TaskHandle_t task;
+    SemaphoreHandle_t stopped;
+    volatile bool running;
+    aic3101_i2s_config_t config;
+    uint32_t frames;                // 每块的帧数
+    size_t block_bytes;
+    void *in;
+    void *out;
+    uint64_t rx_frames;             // 已读取的帧数, 即下一块输入第一帧的序号
+    uint64_t tx_frames;             // 已写入的帧数 (含预装的静音), 即下一块输出第一帧的序号
+    uint64_t callback_total_us;
+    volatile latency_probe_t probe;
+    uint64_t probe_frame;           // 脉冲在输出流中的序号
+    SemaphoreHandle_t probe_done;
+    aic3101_i2s_stats_t stats;
+} aic3101_i2s_t;
+
+static aic3101_i2s_t *engine;
+
+static esp_err_t aic3101_write_reg(const audio_codec_cfg_t *codec_config, uint8_t reg, uint8_t value)
+{
+    uint8_t buffer[] = {reg, value};
+    return i2c_master_transmit(*(codec_config->i2c_cfg->i2c_device_handle), buffer, sizeof(buffer), 100);
+}
+
+// 配置 Codec 的数字音频通路: I2S 从机, MCLK 直接分频得到采样率 (不用 PLL), ADC 和 DAC 上电
+static esp_err_t aic3101_setup_digital(const audio_codec_cfg_t *codec_config, const aic3101_i2s_config_t *config,
+                                       uint32_t mclk_multiple)
+{
+    uint8_t word_length;
+    switch (config->bits_per_sample) {
+    case 16: word_length = 0; break;
+    case 24: word_length = 2; break;
+    default: word_length = 3; break;
+    }
+    // fs(ref) = MCLK / (128 * Q)
+    uint8_t q = mclk_multiple / 128;
+    const uint8_t regs[][2] = {
+        {0, 0x00},                              // Page 0
+        {3, (q & 0x0F) << 3},                   // PLL disabled, Q
+        {102, 0x02},                            // CLKDIV_IN = MCLK
+        {101, 0x01},                            // CODEC_CLKIN = CLKDIV_OUT
+        {2, 0x00},                              // ADC fs = DAC fs = fs(ref)
+        {7, (config->sample_rate % 11025 == 0 ? 0x80 : 0x00) | 0x0A},  // fs(ref) family, left DAC plays left, right plays right
+        {8, 0x00},                              // BCLK and WCLK are inputs
+        {9, word_length << 4},                  // I2S mode, word length
+        {10, 0x00},                             // No data offset
+        {19, 0x7C},                             // LINE1L not connected, power up left ADC
+        {22, 0x7C},                             // LINE1R not connected, power up right ADC
+        {37, 0xC0},                             // Power up left and right DAC
+        {43, 0x00},                             // Left DAC volume 0 dB, unmuted
+        {44, 0x00},                             // Right DAC volume 0 dB, unmuted
+        {82, 0x80},                             // Route DAC_L1 to LEFT_LOP/M, 0 dB
+        {92, 0x80},                             // Route DAC_R1 to RIGHT_LOP/M, 0 dB
+        {86, 0x09},                             // Power up LEFT_LOP/M, unmuted
+        {93, 0x09},                             // Power up RIGHT_LOP/M, unmuted
+    };
+    for (size_t i = 0; i < sizeof(regs) / sizeof(regs[0]); i++) {
+        ESP_RETURN_ON_ERROR(aic3101_write_reg(codec_config, regs[i][0], regs[i][1]), TAG, "write reg %d failed", regs[i][0]);
+    }
+    if (!config->analog_bypass) {
+        // 断开 PGA 到线路输出的模拟直通, 输出只来自 DAC
+        ESP_RETURN_ON_ERROR(aic3101_write_reg(codec_config, 81, 0x00), TAG, "write reg 81 failed");
+        ESP_RETURN_ON_ERROR(aic3101_write_reg(codec_config, 91, 0x00), TAG, "write reg 91 failed");
+    }
+    return ESP_OK;
+}
+
+static IRAM_ATTR bool aic3101_i2s_rx_overflow(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    engine->stats.rx_overflows++;
+    return false;
+}
+
+static IRAM_ATTR bool aic3101_i2s_tx_overflow(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    engine->stats.tx_underflows++;
+    return false;
+}
+
+// 取第 index 个采样的高 16 位
+static int32_t aic3101_sample16(const void *buffer, size_t index)
+{
+    if (engine->config.bits_per_sample == 16) {
+        return ((const int16_t *)buffer)[index];
+    }
+    return ((const int32_t *)buffer)[index] >> 16;
+}
+
+static void aic3101_set_sample16(void *buffer, size_t index, int32_t value)
+{
+    if (engine->config.bits_per_sample == 16) {
+        ((int16_t *)buffer)[index] = value;
+    } else {
+        ((int32_t *)buffer)[index] = value << 16;
+    }
+}
+
+static void aic3101_latency_probe(void)
+{
+    if (engine->probe == PROBE_WAITING) {
+        for (uint32_t i = 0; i < engine->frames; i++) {
+            if (abs(aic3101_sample16(engine->in, i * 2)) > LATENCY_THRESHOLD) {
+                uint64_t latency_frames = engine->rx_frames + i - engine->probe_frame;
+                engine->stats.measured_latency_us = latency_frames * 1000000 / engine->config.sample_rate;
+                engine->probe = PROBE_IDLE;
+                xSemaphoreGive(engine->probe_done);
+                break;
+            }
+        }
+    } else if (engine->probe == PROBE_ARMED) {
+        // 本块输出的第一帧放入脉冲, 从下一块输入开始检测
+        aic3101_set_sample16(engine->out, 0, LATENCY_IMPULSE);
+        aic3101_set_sample16(engine->out, 1, LATENCY_IMPULSE);
+        engine->probe_frame = engine->tx_frames;
+        engine->probe = PROBE_WAITING;
+    }
+}
+
+static void aic3101_i2s_task(void *arg)
+{
+    while (engine->running) {
+        size_t bytes = 0;
+        if (i2s_channel_read(engine->rx, engine->in, engine->block_bytes, &bytes, pdMS_TO_TICKS(100)) != ESP_OK) {
+            continue;
+        }
+        memset(engine->out, 0, engine->block_bytes);
+        if (engine->config.callback) {
+            int64_t start = esp_timer_get_time();
+            engine->config.callback(engine->in, engine->out, engine->frames, engine->config.user_ctx);
+            uint32_t cost = esp_timer_get_time() - start;
+            engine->callback_total_us += cost;
+            if (cost > engine->stats.callback_max_us) {
+                engine->stats.callback_max_us = cost;
+            }
+        }
+        aic3101_latency_probe();
+        i2s_channel_write(engine->tx, engine->out, engine->block_bytes, &bytes, portMAX_DELAY);
+        engine->rx_frames += engine->frames;
+        engine->tx_frames += engine->frames;
+        engine->stats.blocks++;
+        engine->stats.callback_avg_us = engine->callback_total_us / engine->stats.blocks;
+    }
+    xSemaphoreGive(engine->stopped);
+    vTaskDelete(NULL);
+}
+
+static void aic3101_i2s_free(void)
+{
+    if (engine->tx) {
+        i2s_del_channel(engine->tx);
+    }
+    if (engine->rx) {
+        i2s_del_channel(engine->rx);
+    }
+    if (engine->stopped) {
+        vSemaphoreDelete(engine->stopped);
+    }
+    if (engine->probe_done) {
+        vSemaphoreDelete(engine->probe_done);
+    }
+    free(engine->in);
+    free(engine->out);
+    free(engine);
+    engine = NULL;
+}
+
+esp_err_t aic3101_i2s_start(const audio_codec_cfg_t *codec_config, const aic3101_i2s_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(codec_config && config && config->sample_rate, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(config->bits_per_sample == 16 || config->bits_per_sample == 24 || config->bits_per_sample == 32,
+                        ESP_ERR_INVALID_ARG, TAG, "unsupported bits per sample");
+    ESP_RETURN_ON_FALSE(engine == NULL, ESP_ERR_INVALID_STATE, TAG, "already started");
+    esp_err_t ret = ESP_OK;
+    engine = calloc(1, sizeof(aic3101_i2s_t));
+    ESP_RETURN_ON_FALSE(engine, ESP_ERR_NO_MEM, TAG, "no mem for engine");
+    engine->config = *config;
+
+    // 按目标延迟确定每块的帧数
+    size_t frame_bytes = AIC3101_I2S_CHANNELS * (config->bits_per_sample == 16 ? 2 : 4);
+    uint32_t frames = (uint64_t)config->sample_rate * config->latency_us / 1000000 / (I2S_DMA_DESC_NUM + 1);
+    if (frames < I2S_MIN_FRAMES) {
+        frames = I2S_MIN_FRAMES;
+    } else if (frames * frame_bytes > I2S_MAX_BLOCK_BYTES) {
+        frames = I2S_MAX_BLOCK_BYTES / frame_bytes;
+    }
+    engine->frames = frames;
+    engine->block_bytes = frames * frame_bytes;
+    engine->stats.frames_per_block = frames;
+    engine->stats.dma_desc_num = I2S_DMA_DESC_NUM;
+    engine->stats.buffer_latency_us = (uint64_t)(I2S_DMA_DESC_NUM + 1) * frames * 1000000 / config->sample_rate;
+
+    engine->in = heap_caps_calloc(1, engine->block_bytes, MALLOC_CAP_INTERNAL);
+    engine->out = heap_caps_calloc(1, engine->block_bytes, MALLOC_CAP_INTERNAL);
+    engine->stopped = xSemaphoreCreateBinary();
+    engine->probe_done = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(engine->in && engine->out && engine->stopped && engine->probe_done, ESP_ERR_NO_MEM, err, TAG, "no mem for buffers");
+
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_AUTO, I2S_ROLE_MASTER);
+    chan_cfg.dma_desc_num = I2S_DMA_DESC_NUM;
+    chan_cfg.dma_frame_num = frames;
+    chan_cfg.auto_clear = true;     // 发送端来不及时输出静音, 而不是重复旧数据
+    ESP_GOTO_ON_ERROR(i2s_new_channel(&chan_cfg, &engine->tx, &engine->rx), err, TAG, "create i2s channels failed");
+
+    const audio_codec_i2s_cfg_t *pins = codec_config->i2s_cfg;
+    i2s_std_config_t std_cfg = {
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(config->sample_rate),
+        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(config->bits_per_sample, I2S_SLOT_MODE_STEREO),
+        .gpio_cfg = {
+            .mclk = pins->mclk_pin,
+            .bclk = pins->bclk_pin,
+            .ws = pins->lrclk_pin,
+            .dout = pins->dout_pin,
+            .din = pins->din_pin,
+        },
+    };
+    if (config->bits_per_sample == 24) {
+        // 24 位时 BCLK 为 48 fs, MCLK 需要是 3 的倍数
+        std_cfg.clk_cfg.mclk_multiple = I2S_MCLK_MULTIPLE_384;
+    }
+    ESP_GOTO_ON_ERROR(i2s_channel_init_std_mode(engine->tx, &std_cfg), err, TAG, "init tx failed");
+    ESP_GOTO_ON_ERROR(i2s_channel_init_std_mode(engine->rx, &std_cfg), err, TAG, "init rx failed");
+
+    i2s_event_callbacks_t rx_cbs = { .on_recv_q_ovf = aic3101_i2s_rx_overflow };
+    i2s_event_callbacks_t tx_cbs = { .on_send_q_ovf = aic3101_i2s_tx_overflow };
+    ESP_GOTO_ON_ERROR(i2s_channel_register_event_callback(engine->rx, &rx_cbs, NULL), err, TAG, "register rx callback failed");
+    ESP_GOTO_ON_ERROR(i2s_channel_register_event_callback(engine->tx, &tx_cbs, NULL), err, TAG, "register tx callback failed");
+
+    // MCLK 开始输出之后 Codec 才有时钟, 但寄存器可以先配置
+    ESP_GOTO_ON_ERROR(aic3101_setup_digital(codec_config, config, std_cfg.clk_cfg.mclk_multiple), err, TAG, "codec setup failed");
+
+    // 预装满发送环, 之后每读一块写一块, 输出延迟保持固定
+    size_t loaded = 0;
+    do {
+        size_t bytes = 0;
+        ESP_GOTO_ON_ERROR(i2s_channel_preload_data(engine->tx, engine->out, engine->block_bytes, &bytes), err, TAG, "preload failed");
+        loaded += bytes;
+        if (bytes < engine->block_bytes) {
+            break;
+        }
+    } while (loaded < engine->block_bytes * I2S_DMA_DESC_NUM);
+    engine->tx_frames = loaded / frame_bytes;
+
+    ESP_GOTO_ON_ERROR(i2s_channel_enable(engine->tx), err, TAG, "enable tx failed");
+    ESP_GOTO_ON_ERROR(i2s_channel_enable(engine->rx), err, TAG, "enable rx failed");
+
+    engine->running = true;
+    if (xTaskCreatePinnedToCore(aic3101_i2s_task, "aic3101_i2s", 4096, NULL, config->task_priority, &engine->task,
+                                config->task_core) != pdPASS) {
+        engine->running = false;
+        i2s_channel_disable(engine->rx);
+        i2s_channel_disable(engine->tx);
+        ESP_GOTO_ON_FALSE(false, ESP_ERR_NO_MEM, err, TAG, "create task failed");
+    }
+    ESP_LOGI(TAG, "Streaming %lu Hz / %d bit, %lu frames x %d descriptors, buffer latency %lu us",
+             config->sample_rate, config->bits_per_sample, frames, I2S_DMA_DESC_NUM, engine->stats.buffer_latency_us);
+    return ESP_OK;
+
+err:
+    aic3101_i2s_free();
+    return ret;
+}
+
+esp_err_t aic3101_i2s_stop(void)
+{
+    ESP_RETURN_ON_FALSE(engine, ESP_ERR_INVALID_STATE, TAG, "not started");
+    engine->running = false;
+    xSemaphoreTake(engine->stopped, portMAX_DELAY);
+    i2s_channel_disable(engine->rx);
+    i2s_channel_disable(engine->tx);
+    aic3101_i2s_free();
+    return ESP_OK;
+}
+
+esp_err_t aic3101_i2s_measure_latency(uint32_t timeout_ms, uint32_t *latency_us)
+{
+    ESP_RETURN_ON_FALSE(latency_us, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(engine && engine->probe == PROBE_IDLE, ESP_ERR_INVALID_STATE, TAG, "not streaming or busy");
+    xSemaphoreTake(engine->probe_done, 0);
+    engine->probe = PROBE_ARMED;
+    if (xSemaphoreTake(engine->probe_done, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        engine->probe = PROBE_IDLE;
+        return ESP_ERR_TIMEOUT;
+    }
+    *latency_us = engine->stats.measured_latency_us;
+    return ESP_OK;
+}
+
+void aic3101_i2s_get_stats(aic3101_i2s_stats_t *stats)
+{
+    if (engine) {
+        *stats = engine->stats;
+    } else {
+        memset(stats, 0, sizeof(*stats));
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef AIC3101_I2S_H
+#define AIC3101_I2S_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "aic3101.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 数据流固定为立体声, 回调收到的每帧为左右两个采样
+#define AIC3101_I2S_CHANNELS 2
+
+/**
+ * @brief Audio processing callback, called from the streaming task once per DMA block
+ *
+ * Samples are interleaved stereo (left first). The container is int16_t for 16-bit streams
+ * and int32_t (left aligned) for 24 and 32-bit streams.
+ *
+ * @param[in] in Captured frames
+ * @param[out] out Frames to play, already zeroed
+ * @param[in] frames Number of stereo frames in each buffer
+ * @param[in] user_ctx User context passed in the configuration
+ */
+typedef void (*aic3101_i2s_process_cb_t)(const void *in, void *out, size_t frames, void *user_ctx);
+
+/**
+ * @brief I2S streaming configuration
+ */
+typedef struct {
+    uint32_t sample_rate;               /*!< Sample rate in Hz, e.g. 48000 */
+    uint8_t bits_per_sample;            /*!< 16, 24 or 32 */
+    uint32_t latency_us;                /*!< Target round-trip latency, sizes the DMA descriptor rings */
+    aic3101_i2s_process_cb_t callback;  /*!< Processing callback, NULL to play silence and discard the input */
+    void *user_ctx;                     /*!< User context passed to the callback */
+    UBaseType_t task_priority;          /*!< Priority of the streaming task, should be above everything but the drivers */
+    BaseType_t task_core;               /*!< Core the streaming task is pinned to, tskNO_AFFINITY for any */
+    bool analog_bypass;                 /*!< Keep the line-in to line-out analog bypass set up by set_line_to_pa_mode */
+} aic3101_i2s_config_t;
+
+/**
+ * @brief I2S streaming statistics
+ */
+typedef struct {
+    uint32_t blocks;                    /*!< DMA blocks processed */
+    uint32_t frames_per_block;          /*!< Frames in each DMA block */
+    uint32_t dma_desc_num;              /*!< DMA descriptors in each ring */
+    uint32_t rx_overflows;              /*!< Receive queue overflows, the task did not keep up */
+    uint32_t tx_underflows;             /*!< Transmit queue overflows, old data was dropped */
+    uint32_t callback_avg_us;           /*!< Average time spent in the callback */
+    uint32_t callback_max_us;           /*!< Longest time spent in the callback */
+    uint32_t buffer_latency_us;         /*!< Round-trip latency expected from the buffer sizes */
+    uint32_t measured_latency_us;       /*!< Last result of aic3101_i2s_measure_latency, 0 if never measured */
+} aic3101_i2s_stats_t;
+
+/**
+ * @brief Configure the codec for digital audio and start full-duplex I2S streaming
+ *
+ * The codec is an I2S slave clocked from MCLK. The ESP32 is the I2S master.
+ *
+ * @param[in] codec_config Codec configuration, the I2C device must be initialized
+ * @param[in] config Streaming configuration
+ * @return ESP_OK on success
+ */
+esp_err_t aic3101_i2s_start(const audio_codec_cfg_t *codec_config, const aic3101_i2s_config_t *config);
+
+/**
+ * @brief Stop streaming and release the I2S channels
+ */
+esp_err_t aic3101_i2s_stop(void);
+
+/**
+ * @brief Measure the round-trip latency by sending an impulse and waiting for it on the input
+ *
+ * Needs a loopback from the codec line output to the line input, or DOUT wired to DIN.
+ * The output is briefly replaced by the impulse.
+ *
+ * @param[in] timeout_ms Time to wait for the impulse
+ * @param[out] latency_us Measured latency
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if the impulse did not come back
+ */
+esp_err_t aic3101_i2s_measure_latency(uint32_t timeout_ms, uint32_t *latency_us);
+
+void aic3101_i2s_get_stats(aic3101_i2s_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AIC3101_I2S_H */
@@ -0,0 +1,163 @@
+#include "dsp_kernels.h"
+#include <string.h>
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_random.h"
+
+static const char TAG[] = "dsp_bench";
+
+#define BENCH_RUNS     8
+#define BENCH_FFT_SIZE 1024
+#define BENCH_SAMPLES  1024
+#define BENCH_PIXELS   (32 * 8 * 3)
+#define BENCH_RATE     48000
+
+// 多次运行取最少的周期数, 排除中断和缓存的影响
+#define BENCH_CYCLES(result, call)                                  \
+    do {                                                            \
+        uint32_t best_ = UINT32_MAX;                                \
+        for (int run_ = 0; run_ < BENCH_RUNS; run_++) {             \
+            uint32_t start_ = esp_cpu_get_cycle_count();            \
+            call;                                                   \
+            uint32_t cycles_ = esp_cpu_get_cycle_count() - start_;  \
+            if (cycles_ < best_) {                                  \
+                best_ = cycles_;                                    \
+            }                                                       \
+        }                                                           \
+        (result) = best_;                                           \
+    } while (0)
+
+static void *bench_alloc(size_t size) {
+    return heap_caps_aligned_alloc(DSP_ALIGN, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+}
+
+size_t dsp_kernels_benchmark(dsp_bench_result_t *results, size_t max) {
+    size_t count = 0;
+    int16_t *in = bench_alloc(BENCH_SAMPLES * sizeof(int16_t));
+    int16_t *window = bench_alloc(BENCH_SAMPLES * sizeof(int16_t));
+    int16_t *out_ansi = bench_alloc(BENCH_SAMPLES * sizeof(int16_t));
+    int16_t *out_pie = bench_alloc(BENCH_SAMPLES * sizeof(int16_t));
+    dsp_cq15_t *fft = bench_alloc(BENCH_FFT_SIZE * sizeof(dsp_cq15_t));
+    uint32_t *power = bench_alloc(BENCH_FFT_SIZE / 2 * sizeof(uint32_t));
+    uint8_t *pixels = bench_alloc(BENCH_PIXELS);
+    uint8_t *pixels_ansi = bench_alloc(BENCH_PIXELS);
+    uint8_t *pixels_pie = bench_alloc(BENCH_PIXELS);
+    dsp_fft_plan_t plan = {0};
+    if (!in || !window || !out_ansi || !out_pie || !fft || !power || !pixels || !pixels_ansi || !pixels_pie
+        || dsp_fft_plan_init(&plan, BENCH_FFT_SIZE) != ESP_OK) {
+        ESP_LOGE(TAG, "no mem for benchmark buffers");
+        goto out;
+    }
+
+    // 随机输入覆盖正负满幅, 窗取全范围的正值
+    esp_fill_random(in, BENCH_SAMPLES * sizeof(int16_t));
+    esp_fill_random(window, BENCH_SAMPLES * sizeof(int16_t));
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        window[i] &= 0x7FFF;
+    }
+    esp_fill_random(pixels, BENCH_PIXELS);
+
+    if (count < max) {
+        dsp_bench_result_t *r = &results[count++];
+        r->name = "window_q15";
+        r->n = BENCH_SAMPLES;
+        BENCH_CYCLES(r->ansi_cycles, dsp_window_q15_ansi(out_ansi, in, window, BENCH_SAMPLES));
+#if CONFIG_DSP_KERNELS_PIE
+        BENCH_CYCLES(r->pie_cycles, dsp_window_q15(out_pie, in, window, BENCH_SAMPLES));
+        r->bit_exact = memcmp(out_ansi, out_pie, BENCH_SAMPLES * sizeof(int16_t)) == 0;
+#else
+        r->pie_cycles = 0;
+        r->bit_exact = true;
+#endif
+    }
+
+    if (count < max) {
+        dsp_bench_result_t *r = &results[count++];
+        r->name = "u8_scale";
+        r->n = BENCH_PIXELS;
+        BENCH_CYCLES(r->ansi_cycles, dsp_u8_scale_ansi(pixels_ansi, pixels, 179, BENCH_PIXELS));
+#if CONFIG_DSP_KERNELS_PIE
+        BENCH_CYCLES(r->pie_cycles, dsp_u8_scale(pixels_pie, pixels, 179, BENCH_PIXELS));
+        r->bit_exact = memcmp(pixels_ansi, pixels_pie, BENCH_PIXELS) == 0;
+#else
+        r->pie_cycles = 0;
+        r->bit_exact = true;
+#endif
+    }
+
+    if (count < max) {
+        dsp_bench_result_t *r = &results[count++];
+        r->name = "u8_blend_add";
+        r->n = BENCH_PIXELS;
+        r->pie_cycles = 0;
+        r->bit_exact = true;
+        BENCH_CYCLES(r->ansi_cycles, dsp_u8_blend_add(pixels_ansi, pixels, 64, BENCH_PIXELS));
+    }
+
+    if (count < max) {
+        dsp_bench_result_t *r = &results[count++];
+        r->name = "fft_r4_q15";
+        r->n = BENCH_FFT_SIZE;
+        r->pie_cycles = 0;
+        r->bit_exact = true;
+        // 各分量不超过半满幅, 复数的模小于 32767; 之后每次变换上一次的结果, 模不会增长
+        for (int i = 0; i < BENCH_FFT_SIZE; i++) {
+            fft[i].re = in[i] >> 1;
+            fft[i].im = in[BENCH_FFT_SIZE - 1 - i] >> 1;
+        }
+        BENCH_CYCLES(r->ansi_cycles, dsp_fft_r4_q15(&plan, fft));
+    }
+
+    if (count < max) {
+        dsp_bench_result_t *r = &results[count++];
+        r->name = "magnitude_sq_q15";
+        r->n = BENCH_FFT_SIZE / 2;
+        r->pie_cycles = 0;
+        r->bit_exact = true;
+        BENCH_CYCLES(r->ansi_cycles, dsp_magnitude_sq_q15(power, fft, BENCH_FFT_SIZE / 2));
+    }
+
+    if (count < max) {
+        dsp_bench_result_t *r = &results[count++];
+        r->name = "band_bank_3";
+        r->n = BENCH_SAMPLES / 2;
+        r->pie_cycles = 0;
+        r->bit_exact = true;
+        // 环境模式的低音/中音/高音三个频带, 输入为 16 位立体声
+        const dsp_band_spec_t specs[] = {{40, 250}, {250, 4000}, {4000, 16000}};
+        dsp_band_bank_t bank;
+        float energy[3];
+        dsp_band_bank_init(&bank, BENCH_RATE, specs, 3);
+        BENCH_CYCLES(r->ansi_cycles, dsp_band_bank_process(&bank, in, BENCH_SAMPLES / 2, 2, 16));
+        dsp_band_bank_read(&bank, energy);
+        // 按 48 kHz 实时处理所占的 CPU 比例
+        uint64_t cycles_per_s = (uint64_t)r->ansi_cycles * BENCH_RATE / r->n;
+        uint32_t load_permille = cycles_per_s * 1000 / (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000000);
+        ESP_LOGI(TAG, "band_bank_3 at %d Hz: %lu.%lu%% of one core", BENCH_RATE, load_permille / 10, load_permille % 10);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const dsp_bench_result_t *r = &results[i];
+        if (r->pie_cycles) {
+            ESP_LOGI(TAG, "%-16s n=%-5lu C %7lu cycles, PIE %7lu cycles (%lu.%02lux)%s", r->name, r->n, r->ansi_cycles,
+                     r->pie_cycles, r->ansi_cycles / r->pie_cycles, r->ansi_cycles * 100 / r->pie_cycles % 100,
+                     r->bit_exact ? "" : ", OUTPUT MISMATCH");
+        } else {
+            ESP_LOGI(TAG, "%-16s n=%-5lu C %7lu cycles", r->name, r->n, r->ansi_cycles);
+        }
+    }
+
+out:
+    dsp_fft_plan_free(&plan);
+    heap_caps_free(in);
+    heap_caps_free(window);
+    heap_caps_free(out_ansi);
+    heap_caps_free(out_pie);
+    heap_caps_free(fft);
+    heap_caps_free(power);
+    heap_caps_free(pixels);
+    heap_caps_free(pixels_ansi);
+    heap_caps_free(pixels_pie);
+    return count;
+}
@@ -0,0 +1,235 @@
+#include "dsp_kernels.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_check.h"
+
+static const char TAG[] = "dsp";
+
+#if CONFIG_DSP_KERNELS_PIE
+// dsp_kernels_pie.S, 每个 block 为 16 字节, 指针必须 16 字节对齐
+void dsp_window_q15_pie(int16_t *out, const int16_t *in, const int16_t *window, size_t blocks);
+void dsp_u8_scale_pie(uint8_t *out, const uint8_t *in, const uint8_t *scale, size_t blocks);
+
+static inline bool dsp_aligned(const void *p) {
+    return ((uintptr_t)p & (DSP_ALIGN - 1)) == 0;
+}
+#endif
+
+esp_err_t dsp_fft_plan_init(dsp_fft_plan_t *plan, uint32_t n) {
+    ESP_RETURN_ON_FALSE(plan, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    // 4 的幂: 只有一位为 1, 且在偶数位上
+    ESP_RETURN_ON_FALSE(n >= 16 && n <= 16384 && (n & (n - 1)) == 0 && (n & 0x55555555),
+                        ESP_ERR_INVALID_ARG, TAG, "size must be a power of 4");
+    plan->n = n;
+    plan->twiddle = malloc(n * 3 / 4 * sizeof(dsp_cq15_t));
+    plan->reverse = malloc(n * sizeof(uint16_t));
+    if (plan->twiddle == NULL || plan->reverse == NULL) {
+        dsp_fft_plan_free(plan);
+        return ESP_ERR_NO_MEM;
+    }
+    for (uint32_t k = 0; k < n * 3 / 4; k++) {
+        double angle = 2.0 * M_PI * k / n;
+        plan->twiddle[k].re = lround(32767.0 * cos(angle));
+        plan->twiddle[k].im = lround(-32767.0 * sin(angle));
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t r = 0;
+        for (uint32_t v = i, m = n; m > 1; m >>= 2, v >>= 2) {
+            r = (r << 2) | (v & 3);
+        }
+        plan->reverse[i] = r;
+    }
+    return ESP_OK;
+}
+
+void dsp_fft_plan_free(dsp_fft_plan_t *plan) {
+    free(plan->twiddle);
+    free(plan->reverse);
+    plan->twiddle = NULL;
+    plan->reverse = NULL;
+}
+
+// 乘法和每级的 1/4 缩放都取最近值: 截断的 -0.5 LSB 偏差会逐级累积, 1024 点时超过 4 LSB
+static inline void dsp_cmul_q15(const dsp_cq15_t *x, const dsp_cq15_t *w, int32_t *re, int32_t *im) {
+    *re = (x->re * w->re - x->im * w->im + (1 << 14)) >> 15;
+    *im = (x->re * w->im + x->im * w->re + (1 << 14)) >> 15;
+}
+
+void dsp_fft_r4_q15(const dsp_fft_plan_t *plan, dsp_cq15_t *data) {
+    const uint32_t n = plan->n;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t j = plan->reverse[i];
+        if (i < j) {
+            dsp_cq15_t t = data[i];
+            data[i] = data[j];
+            data[j] = t;
+        }
+    }
+    // q 为子序列长度, 每级把 4 个长度为 q 的子变换合成一个长度为 4q 的变换
+    for (uint32_t q = 1; q < n; q <<= 2) {
+        const uint32_t size = q << 2;
+        const uint32_t step = n / size;
+        for (uint32_t start = 0; start < n; start += size) {
+            dsp_cq15_t *x = &data[start];
+            for (uint32_t k = 0; k < q; k++, x++) {
+                int32_t ar = x[0].re;
+                int32_t ai = x[0].im;
+                int32_t br, bi, cr, ci, dr, di;
+                dsp_cmul_q15(&x[q], &plan->twiddle[k * step], &br, &bi);
+                dsp_cmul_q15(&x[2 * q], &plan->twiddle[2 * k * step], &cr, &ci);
+                dsp_cmul_q15(&x[3 * q], &plan->twiddle[3 * k * step], &dr, &di);
+                // X0 = a + b + c + d, X1 = a - jb - c + jd, X2 = a - b + c - d, X3 = a + jb - c - jd
+                int32_t s0r = ar + cr, s0i = ai + ci;
+                int32_t s1r = ar - cr, s1i = ai - ci;
+                int32_t s2r = br + dr, s2i = bi + di;
+                int32_t s3r = br - dr, s3i = bi - di;
+                x[0].re = (s0r + s2r + 2) >> 2;
+                x[0].im = (s0i + s2i + 2) >> 2;
+                x[q].re = (s1r + s3i + 2) >> 2;
+                x[q].im = (s1i - s3r + 2) >> 2;
+                x[2 * q].re = (s0r - s2r + 2) >> 2;
+                x[2 * q].im = (s0i - s2i + 2) >> 2;
+                x[3 * q].re = (s1r - s3i + 2) >> 2;
+                x[3 * q].im = (s1i + s3r + 2) >> 2;
+            }
+        }
+    }
+}
+
+void dsp_window_q15_ansi(int16_t *out, const int16_t *in, const int16_t *window, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = (in[i] * window[i]) >> 15;
+    }
+}
+
+void dsp_window_q15(int16_t *out, const int16_t *in, const int16_t *window, size_t n) {
+#if CONFIG_DSP_KERNELS_PIE
+    if (dsp_aligned(out) && dsp_aligned(in) && dsp_aligned(window)) {
+        size_t blocks = n / 8;
+        dsp_window_q15_pie(out, in, window, blocks);
+        out += blocks * 8;
+        in += blocks * 8;
+        window += blocks * 8;
+        n -= blocks * 8;
+    }
+#endif
+    dsp_window_q15_ansi(out, in, window, n);
+}
+
+void dsp_magnitude_sq_q15(uint32_t *out, const dsp_cq15_t *in, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = (uint32_t)(in[i].re * in[i].re) + (uint32_t)(in[i].im * in[i].im);
+    }
+}
+
+void dsp_u8_scale_ansi(uint8_t *out, const uint8_t *in, uint8_t scale, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = (in[i] * scale) >> 8;
+    }
+}
+
+void dsp_u8_scale(uint8_t *out, const uint8_t *in, uint8_t scale, size_t n) {
+#if CONFIG_DSP_KERNELS_PIE
+    if (dsp_aligned(out) && dsp_aligned(in)) {
+        size_t blocks = n / 16;
+        dsp_u8_scale_pie(out, in, &scale, blocks);
+        out += blocks * 16;
+        in += blocks * 16;
+        n -= blocks * 16;
+    }
+#endif
+    dsp_u8_scale_ansi(out, in, scale, n);
+}
+
+// PIE 没有无符号 8 位的饱和加法, 只有 C 实现
+void dsp_u8_blend_add(uint8_t *dst, const uint8_t *src, uint8_t alpha, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        uint32_t v = dst[i] + ((src[i] * alpha) >> 8);
+        dst[i] = v > 255 ? 255 : v;
+    }
+}
+
+// RBJ 二阶 Butterworth (Q = 1/√2) 高通或低通
+static void dsp_biquad_design(dsp_biquad_t *biquad, double cutoff_hz, uint32_t sample_rate, bool high_pass) {
+    double w0 = 2.0 * M_PI * cutoff_hz / sample_rate;
+    double cos_w0 = cos(w0);
+    double alpha = sin(w0) / M_SQRT2;
+    double a0 = 1.0 + alpha;
+    double b1 = high_pass ? -(1.0 + cos_w0) : 1.0 - cos_w0;
+    biquad->b0 = b1 / (high_pass ? -2.0 : 2.0) / a0;
+    biquad->b1 = b1 / a0;
+    biquad->b2 = biquad->b0;
+    biquad->a1 = -2.0 * cos_w0 / a0;
+    biquad->a2 = (1.0 - alpha) / a0;
+}
+
+esp_err_t dsp_band_bank_init(dsp_band_bank_t *bank, uint32_t sample_rate, const dsp_band_spec_t *specs, size_t count) {
+    ESP_RETURN_ON_FALSE(bank && specs && count <= DSP_BAND_BANK_MAX, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    memset(bank, 0, sizeof(*bank));
+    for (size_t i = 0; i < count; i++) {
+        const dsp_band_spec_t *spec = &specs[i];
+        ESP_RETURN_ON_FALSE(spec->low_hz > 0 && spec->high_hz > spec->low_hz && spec->high_hz < sample_rate / 2.0f,
+                            ESP_ERR_INVALID_ARG, TAG, "invalid band %.0f-%.0f Hz", spec->low_hz, spec->high_hz);
+        dsp_biquad_design(&bank->bands[i].high_pass, spec->low_hz, sample_rate, true);
+        dsp_biquad_design(&bank->bands[i].low_pass, spec->high_hz, sample_rate, false);
+    }
+    bank->count = count;
+    return ESP_OK;
+}
+
+static inline float dsp_sample_mono(const void *in, size_t i, uint8_t channels, uint8_t bits_per_sample) {
+    // 归一化到 [-1, 1)
+    if (bits_per_sample == 16) {
+        const int16_t *s = (const int16_t *)in + i * channels;
+        return (channels == 2 ? s[0] + s[1] : 2 * s[0]) * (1.0f / 65536.0f);
+    }
+    const int32_t *s = (const int32_t *)in + i * channels;
+    return (channels == 2 ? (s[0] >> 1) + (s[1] >> 1) : s[0]) * (1.0f / 2147483648.0f);
+}
+
+// 滤波一个频带, 返回 energy 加上本块输出的平方和
+static float dsp_band_filter(dsp_band_t *band, const void *in, size_t frames, uint8_t channels, uint8_t bits_per_sample, float energy) {
+    // 系数和状态留在寄存器里
+    dsp_biquad_t hp = band->high_pass;
+    dsp_biquad_t lp = band->low_pass;
+    for (size_t i = 0; i < frames; i++) {
+        float x = dsp_sample_mono(in, i, channels, bits_per_sample);
+        float h = hp.b0 * x + hp.z1;
+        hp.z1 = hp.b1 * x - hp.a1 * h + hp.z2;
+        hp.z2 = hp.b2 * x - hp.a2 * h;
+        float y = lp.b0 * h + lp.z1;
+        lp.z1 = lp.b1 * h - lp.a1 * y + lp.z2;
+        lp.z2 = lp.b2 * h - lp.a2 * y;
+        energy += y * y;
+    }
+    band->high_pass.z1 = hp.z1;
+    band->high_pass.z2 = hp.z2;
+    band->low_pass.z1 = lp.z1;
+    band->low_pass.z2 = lp.z2;
+    return energy;
+}
+
+void dsp_band_bank_process(dsp_band_bank_t *bank, const void *in, size_t frames, uint8_t channels, uint8_t bits_per_sample) {
+    for (uint32_t b = 0; b < bank->count; b++) {
+        dsp_band_t *band = &bank->bands[b];
+        band->energy = dsp_band_filter(band, in, frames, channels, bits_per_sample, band->energy);
+    }
+    bank->samples += frames;
+}
+
+void dsp_band_bank_accumulate(dsp_band_bank_t *bank, const void *in, size_t frames, uint8_t channels, uint8_t bits_per_sample, float *energy) {
+    for (uint32_t b = 0; b < bank->count; b++) {
+        energy[b] = dsp_band_filter(&bank->bands[b], in, frames, channels, bits_per_sample, energy[b]);
+    }
+}
+
+uint32_t dsp_band_bank_read(dsp_band_bank_t *bank, float *mean_square) {
+    uint32_t samples = bank->samples;
+    for (uint32_t b = 0; b < bank->count; b++) {
+        mean_square[b] = samples ? bank->bands[b].energy / samples : 0.0f;
+        bank->bands[b].energy = 0.0f;
+    }
+    bank->samples = 0;
+    return samples;
+}
@@ -0,0 +1,183 @@
+#ifndef DSP_KERNELS_H
+#define DSP_KERNELS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 向量指令每次处理 16 字节, 缓冲按此对齐时才会走 PIE 路径, 否则退回 C 实现
+// 只有 dsp_window_q15 和 dsp_u8_scale 有 PIE 版本, 其余内核只有 C 实现
+#define DSP_ALIGN 16
+#define DSP_ALIGNED __attribute__((aligned(DSP_ALIGN)))
+
+/**
+ * @brief Q15 complex sample
+ */
+typedef struct {
+    int16_t re;
+    int16_t im;
+} dsp_cq15_t;
+
+/**
+ * @brief Radix-4 FFT plan: twiddles and digit-reversal permutation for one size
+ */
+typedef struct {
+    uint32_t n;                 /*!< FFT length, a power of 4 */
+    dsp_cq15_t *twiddle;        /*!< e^(-j2πk/n) for k < 3n/4 */
+    uint16_t *reverse;          /*!< Base-4 digit-reversed index of each position */
+} dsp_fft_plan_t;
+
+// 一组带通检测器最多的频带数
+#define DSP_BAND_BANK_MAX 8
+
+/**
+ * @brief Pass band of one detector
+ */
+typedef struct {
+    float low_hz;               /*!< Lower -3 dB edge */
+    float high_hz;              /*!< Upper -3 dB edge */
+} dsp_band_spec_t;
+
+/**
+ * @brief Biquad section (transposed direct form II), coefficients normalised to a0 = 1
+ */
+typedef struct {
+    float b0;
+    float b1;
+    float b2;
+    float a1;
+    float a2;
+    float z1;                   /*!< Filter state */
+    float z2;
+} dsp_biquad_t;
+
+/**
+ * @brief Band detector: Butterworth high-pass at the lower edge, low-pass at the upper edge
+ */
+typedef struct {
+    dsp_biquad_t high_pass;
+    dsp_biquad_t low_pass;
+    float energy;               /*!< Sum of squared outputs since the last read */
+} dsp_band_t;
+
+/**
+ * @brief Bank of band-pass energy detectors
+ */
+typedef struct {
+    uint32_t count;             /*!< Bands in use */
+    uint32_t samples;           /*!< Samples accumulated since the last read */
+    dsp_band_t bands[DSP_BAND_BANK_MAX];
+} dsp_band_bank_t;
+
+/**
+ * @brief Kernel benchmark result, cycle counts are for one call
+ */
+typedef struct {
+    const char *name;           /*!< Kernel name */
+    uint32_t n;                 /*!< Elements processed per call */
+    uint32_t ansi_cycles;       /*!< Portable C implementation */
+    uint32_t pie_cycles;        /*!< PIE vector implementation, 0 if the kernel has none on this target */
+    bool bit_exact;             /*!< Both implementations produced identical output */
+} dsp_bench_result_t;
+
+/**
+ * @brief Precompute the tables for an n-point radix-4 FFT
+ *
+ * @param[out] plan Plan to fill, release with dsp_fft_plan_free
+ * @param[in] n FFT length, a power of 4 from 16 to 16384
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG or ESP_ERR_NO_MEM
+ */
+esp_err_t dsp_fft_plan_init(dsp_fft_plan_t *plan, uint32_t n);
+
+void dsp_fft_plan_free(dsp_fft_plan_t *plan);
+
+/**
+ * @brief In-place radix-4 decimation-in-time complex FFT
+ *
+ * Every stage scales by 1/4, so the output is the DFT divided by n. The input must not
+ * exceed a magnitude of 32767, which always holds for real input (im = 0).
+ */
+void dsp_fft_r4_q15(const dsp_fft_plan_t *plan, dsp_cq15_t *data);
+
+// out[i] = (in[i] * window[i]) >> 15, out 可以与 in 相同
+void dsp_window_q15(int16_t *out, const int16_t *in, const int16_t *window, size_t n);
+void dsp_window_q15_ansi(int16_t *out, const int16_t *in, const int16_t *window, size_t n);
+
+// out[i] = re² + im², 不会溢出
+void dsp_magnitude_sq_q15(uint32_t *out, const dsp_cq15_t *in, size_t n);
+
+// out[i] = (in[i] * scale) >> 8, out 可以与 in 相同
+void dsp_u8_scale(uint8_t *out, const uint8_t *in, uint8_t scale, size_t n);
+void dsp_u8_scale_ansi(uint8_t *out, const uint8_t *in, uint8_t scale, size_t n);
+
+// 叠加混合: dst[i] = min(255, dst[i] + ((src[i] * alpha) >> 8))
+void dsp_u8_blend_add(uint8_t *dst, const uint8_t *src, uint8_t alpha, size_t n);
+
+/**
+ * @brief Design the filters of each band
+ *
+ * Each band is a second-order Butterworth high-pass at low_hz followed by a second-order
+ * Butterworth low-pass at high_hz, so adjacent bands cross over at -3 dB with 12 dB/octave skirts.
+ *
+ * @param[out] bank Bank to initialise
+ * @param[in] sample_rate Sample rate in Hz
+ * @param[in] specs Pass bands, edges must be below half the sample rate
+ * @param[in] count Number of bands, at most DSP_BAND_BANK_MAX
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for a bad band
+ */
+esp_err_t dsp_band_bank_init(dsp_band_bank_t *bank, uint32_t sample_rate, const dsp_band_spec_t *specs, size_t count);
+
+/**
+ * @brief Filter a whole block and accumulate each band's energy
+ *
+ * Stereo input is mixed to mono. 24 and 32-bit samples use the int32_t left-aligned container
+ * of the I2S driver, so a DMA buffer can be passed as is.
+ *
+ * @param[in] in Interleaved samples
+ * @param[in] frames Frames in the block
+ * @param[in] channels 1 or 2
+ * @param[in] bits_per_sample 16, 24 or 32
+ */
+void dsp_band_bank_process(dsp_band_bank_t *bank, const void *in, size_t frames, uint8_t channels, uint8_t bits_per_sample);
+
+/**
+ * @brief Filter a whole block and add each band's energy to the caller's sums
+ *
+ * Same filtering as dsp_band_bank_process, but the bank's own energies and sample count are
+ * left alone, so a caller that already counts samples needs no read per block.
+ *
+ * @param[in,out] energy Sum of squared outputs of each band, relative to full scale. Divided by
+ *                       the number of frames it covers, it gives the mean square that
+ *                       dsp_band_bank_read would return.
+ */
+void dsp_band_bank_accumulate(dsp_band_bank_t *bank, const void *in, size_t frames, uint8_t channels, uint8_t bits_per_sample, float *energy);
+
+/**
+ * @brief Read and reset the accumulated energies
+ *
+ * @param[out] mean_square Mean square of each band's output since the last read, relative to
+ *                         full scale. A full-scale sine in the pass band reads 0.5.
+ * @return Samples the energies were averaged over, 0 if there were none (the outputs are then 0)
+ */
+uint32_t dsp_band_bank_read(dsp_band_bank_t *bank, float *mean_square);
+
+/**
+ * @brief Time every kernel on internal RAM buffers and compare the C and PIE outputs
+ *
+ * @param[out] results Results, one per kernel
+ * @param[in] max Capacity of results
+ * @return Number of results written
+ */
+size_t dsp_kernels_benchmark(dsp_bench_result_t *results, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DSP_KERNELS_H */
@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "led_strip_types.h"
+#include "esp_idf_version.h"
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+#include "driver/rmt_types.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief LED Strip RMT specific configuration
+ */
+typedef struct {
+#if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 0, 0)
+    uint8_t rmt_channel;        /*!< Specify the channel number, the legacy RMT driver doesn't support channel allocator */
+#else // new driver supports specify the clock source and clock resolution
+    rmt_clock_source_t clk_src; /*!< RMT clock source */
+    uint32_t resolution_hz;     /*!< RMT tick resolution, if set to zero, a default resolution (10MHz) will be applied */
+#endif
+    size_t mem_block_symbols;   /*!< How many RMT symbols can one RMT channel hold at one time. Set to 0 will fallback to use the default size. */
+    struct {
+        uint32_t with_dma: 1;   /*!< Use DMA to transmit data */
+        uint32_t with_symbol_cache: 1; /*!< Keep the whole frame pre-encoded as RMT symbols (32 bytes per color byte) and only re-encode the bytes that changed,
+                                            so each transmission is a plain symbol copy. Not supported by the legacy driver */
+        uint32_t double_buffer: 1; /*!< Keep the RMT channel enabled and draw into a back buffer while the front buffer is in flight,
+                                        so `led_strip_refresh_async` returns without waiting for the wire time. Not supported by the legacy driver */
+    } flags;                    /*!< Extra driver flags */
+    led_strip_refresh_done_cb_t on_refresh_done; /*!< Called from ISR context when a frame has been sent out, only used with `double_buffer`. Can be NULL */
+    void *user_ctx;             /*!< User context passed to `on_refresh_done` */
+} led_strip_rmt_config_t;
+
+/**
+ * @brief LED Strip RMT encoder statistics, only filled when `with_symbol_cache` is enabled
+ */
+typedef struct {
+    uint32_t frames;             /*!< Frames pre-encoded into the symbol cache */
+    uint32_t last_encode_cycles; /*!< CPU cycles spent pre-encoding the last frame */
+    uint32_t max_encode_cycles;  /*!< Largest number of CPU cycles spent pre-encoding a frame */
+    uint32_t last_bytes_encoded; /*!< Color bytes re-encoded for the last frame, the others were unchanged */
+} led_strip_rmt_encoder_stats_t;
+
+/**
+ * @brief Create LED strip based on RMT TX channel
+ *
+ * @param led_config LED strip configuration
+ * @param rmt_config RMT specific configuration
+ * @param ret_strip Returned LED strip handle
+ * @return
+ *      - ESP_OK: create LED strip handle successfully
+ *      - ESP_ERR_INVALID_ARG: create LED strip handle failed because of invalid argument
+ *      - ESP_ERR_NO_MEM: create LED strip handle failed because of out of memory
+ *      - ESP_FAIL: create LED strip handle failed because some other error
+ */
+esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const led_strip_rmt_config_t *rmt_config, led_strip_handle_t *ret_strip);
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+/**
+ * @brief Get the encoder statistics of an LED strip created by `led_strip_new_rmt_device`
+ *
+ * @param strip LED strip handle, must be backed by RMT
+ * @param stats Returned statistics
+ * @return
+ *      - ESP_OK: get statistics successfully
+ *      - ESP_ERR_INVALID_ARG: get statistics failed because of invalid argument, or the strip is not an RMT strip
+ */
+esp_err_t led_strip_rmt_get_encoder_stats(led_strip_handle_t strip, led_strip_rmt_encoder_stats_t *stats);
+
+/**
+ * @brief Symbol cache encode cost for one strip length, in CPU cycles (best of several runs)
+ */
+typedef struct {
+    uint32_t leds;               /*!< Number of RGB LEDs in the frame */
+    uint32_t bytes_cycles;       /*!< Baseline: turn every bit of the frame into a symbol, as the bytes encoder does on each transmission */
+    uint32_t full_cycles;        /*!< Encode a frame that shares nothing with the cached one */
+    uint32_t partial_cycles;     /*!< Re-encode a frame in which one pixel in 16 changed */
+    uint32_t unchanged_cycles;   /*!< Compare a frame identical to the cached one */
+} led_strip_rmt_encoder_bench_t;
+
+/**
+ * @brief Measure the CPU cost of pre-encoding frames into the symbol cache against the per-bit baseline
+ *
+ * @note Creates a stand-alone WS2812 encoder, no RMT channel is needed. The cache for 1024 LEDs
+ *       takes 96 KB of internal RAM while the benchmark runs.
+ * @note The bytes encoder only runs inside a transmission, so the baseline is the same per-bit symbol
+ *       selection timed on its own. It leaves out the bytes encoder's per-call bookkeeping, which makes
+ *       the measured gain a lower bound.
+ *
+ * @param leds Number of RGB LEDs per frame
+ * @param result Returned cycle counts
+ * @return
+ *      - ESP_OK: benchmark finished
+ *      - ESP_ERR_INVALID_ARG: invalid argument
+ *      - ESP_ERR_NO_MEM: not enough memory for the frames or the symbol cache
+ */
+esp_err_t led_strip_rmt_encoder_benchmark(uint32_t leds, led_strip_rmt_encoder_bench_t *result);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
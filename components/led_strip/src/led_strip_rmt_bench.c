@@ -0,0 +1,124 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_check.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_random.h"
+#include "led_strip_rmt_encoder.h"
+
+static const char *TAG = "led_rmt_bench";
+
+#define LED_STRIP_BENCH_RUNS 8
+#define LED_STRIP_BENCH_RESOLUTION 10000000 // same default resolution as led_strip_rmt_dev.c
+
+// the per-bit work of the RMT bytes encoder: one symbol per bit, MSB first, repeated for every frame
+// noinline keeps the stores from being dropped, the symbols are never read
+__attribute__((noinline)) static void led_strip_bench_encode_bits(rmt_symbol_word_t *symbols, const uint8_t *data, size_t size)
+{
+    // WS2812 timing, same as led_strip_rmt_encoder.c
+    const rmt_symbol_word_t bit0 = {
+        .level0 = 1,
+        .duration0 = 0.3 * LED_STRIP_BENCH_RESOLUTION / 1000000,
+        .level1 = 0,
+        .duration1 = 0.9 * LED_STRIP_BENCH_RESOLUTION / 1000000,
+    };
+    const rmt_symbol_word_t bit1 = {
+        .level0 = 1,
+        .duration0 = 0.9 * LED_STRIP_BENCH_RESOLUTION / 1000000,
+        .level1 = 0,
+        .duration1 = 0.3 * LED_STRIP_BENCH_RESOLUTION / 1000000,
+    };
+    for (size_t i = 0; i < size; i++) {
+        for (int bit = 0; bit < 8; bit++) {
+            *symbols++ = (data[i] & (0x80 >> bit)) ? bit1 : bit0;
+        }
+    }
+}
+
+static esp_err_t led_strip_bench_bytes(const uint8_t *frame, size_t size, uint32_t *ret_cycles)
+{
+    // internal RAM like the symbol cache, freed before the cache is allocated so the peak stays at one buffer
+    rmt_symbol_word_t *symbols = heap_caps_malloc(size * 8 * sizeof(rmt_symbol_word_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    ESP_RETURN_ON_FALSE(symbols, ESP_ERR_NO_MEM, TAG, "no mem for baseline symbols");
+    uint32_t best = UINT32_MAX;
+    for (int run = 0; run < LED_STRIP_BENCH_RUNS; run++) {
+        uint32_t start = esp_cpu_get_cycle_count();
+        led_strip_bench_encode_bits(symbols, frame, size);
+        uint32_t cycles = esp_cpu_get_cycle_count() - start;
+        if (cycles < best) {
+            best = cycles;
+        }
+    }
+    free(symbols);
+    *ret_cycles = best;
+    return ESP_OK;
+}
+
+// encode `frame` on top of `base` several times and keep the cheapest run, which excludes interrupts and cache misses
+static esp_err_t led_strip_bench_encode(rmt_encoder_handle_t encoder, const uint8_t *base, const uint8_t *frame, size_t size, uint32_t *ret_cycles)
+{
+    uint32_t best = UINT32_MAX;
+    for (int run = 0; run < LED_STRIP_BENCH_RUNS; run++) {
+        led_strip_rmt_encoder_stats_t stats;
+        ESP_RETURN_ON_ERROR(rmt_led_strip_encoder_update(encoder, base, size), TAG, "encode base frame failed");
+        ESP_RETURN_ON_ERROR(rmt_led_strip_encoder_update(encoder, frame, size), TAG, "encode frame failed");
+        ESP_RETURN_ON_ERROR(rmt_led_strip_encoder_get_stats(encoder, &stats), TAG, "get stats failed");
+        if (stats.last_encode_cycles < best) {
+            best = stats.last_encode_cycles;
+        }
+    }
+    *ret_cycles = best;
+    return ESP_OK;
+}
+
+esp_err_t led_strip_rmt_encoder_benchmark(uint32_t leds, led_strip_rmt_encoder_bench_t *result)
+{
+    esp_err_t ret = ESP_OK;
+    rmt_encoder_handle_t encoder = NULL;
+    uint8_t *base = NULL;
+    uint8_t *frame = NULL;
+    ESP_RETURN_ON_FALSE(leds && result, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    size_t size = leds * 3;
+    base = malloc(size);
+    frame = malloc(size);
+    ESP_GOTO_ON_FALSE(base && frame, ESP_ERR_NO_MEM, err, TAG, "no mem for frames");
+    result->leds = leds;
+    // every byte differs between the two frames
+    esp_fill_random(base, size);
+    for (size_t i = 0; i < size; i++) {
+        frame[i] = ~base[i];
+    }
+    // the bytes encoder redoes every bit on every refresh, whatever changed
+    ESP_GOTO_ON_ERROR(led_strip_bench_bytes(frame, size, &result->bytes_cycles), err, TAG, "baseline failed");
+
+    led_strip_encoder_config_t config = {
+        .resolution = LED_STRIP_BENCH_RESOLUTION,
+        .led_model = LED_MODEL_WS2812,
+        .symbol_cache_size = size,
+    };
+    ESP_GOTO_ON_ERROR(rmt_new_led_strip_encoder(&config, &encoder), err, TAG, "create encoder failed");
+    ESP_GOTO_ON_ERROR(led_strip_bench_encode(encoder, base, frame, size, &result->full_cycles), err, TAG, "full frame failed");
+    // one pixel in 16 changed, about what a clock digit update touches on a 32x8 panel
+    memcpy(frame, base, size);
+    for (size_t i = 0; i < size; i += 16 * 3) {
+        frame[i] = ~base[i];
+        frame[i + 1] = ~base[i + 1];
+        frame[i + 2] = ~base[i + 2];
+    }
+    ESP_GOTO_ON_ERROR(led_strip_bench_encode(encoder, base, frame, size, &result->partial_cycles), err, TAG, "partial frame failed");
+    ESP_GOTO_ON_ERROR(led_strip_bench_encode(encoder, base, base, size, &result->unchanged_cycles), err, TAG, "unchanged frame failed");
+
+err:
+    if (encoder) {
+        rmt_del_encoder(encoder);
+    }
+    free(base);
+    free(frame);
+    return ret;
+}
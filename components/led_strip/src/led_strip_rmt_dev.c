@@ -0,0 +1,309 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <sys/cdefs.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "driver/rmt_tx.h"
+#include "led_strip.h"
+#include "led_strip_interface.h"
+#include "led_strip_rmt_encoder.h"
+
+#define LED_STRIP_RMT_DEFAULT_RESOLUTION 10000000 // 10MHz resolution
+#define LED_STRIP_RMT_DEFAULT_TRANS_QUEUE_SIZE 4
+// the memory size of each RMT channel, in words (4 bytes)
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define LED_STRIP_RMT_DEFAULT_MEM_BLOCK_SYMBOLS 64
+#else
+#define LED_STRIP_RMT_DEFAULT_MEM_BLOCK_SYMBOLS 48
+#endif
+
+static const char *TAG = "led_strip_rmt";
+
+typedef struct {
+    led_strip_t base;
+    rmt_channel_handle_t rmt_chan;
+    rmt_encoder_handle_t strip_encoder;
+    SemaphoreHandle_t refresh_done_sem;          // given from the ISR when a frame is out, double buffer mode only
+    led_strip_refresh_done_cb_t on_refresh_done;
+    void *user_ctx;
+    uint32_t strip_len;
+    uint8_t bytes_per_pixel;
+    bool double_buffer;
+    bool with_symbol_cache;
+    bool in_flight;
+    uint8_t *pixel_buf;                          // buffer written by set_pixel (the back buffer in double buffer mode)
+    uint8_t *front_buf;                          // buffer being transmitted, double buffer mode only
+    uint8_t buffers[];
+} led_strip_rmt_obj;
+
+static esp_err_t led_strip_rmt_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(index < rmt_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    uint32_t start = index * rmt_strip->bytes_per_pixel;
+    // In thr order of GRB, as LED strip like WS2812 sends out pixels in this order
+    rmt_strip->pixel_buf[start + 0] = green & 0xFF;
+    rmt_strip->pixel_buf[start + 1] = red & 0xFF;
+    rmt_strip->pixel_buf[start + 2] = blue & 0xFF;
+    if (rmt_strip->bytes_per_pixel > 3) {
+        rmt_strip->pixel_buf[start + 3] = 0;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_set_pixels(led_strip_t *strip, uint32_t start, const uint8_t *rgb, uint32_t count)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(count <= rmt_strip->strip_len && start <= rmt_strip->strip_len - count, ESP_ERR_INVALID_ARG, TAG, "span out of maximum number of LEDs");
+    uint8_t *buf = rmt_strip->pixel_buf + start * rmt_strip->bytes_per_pixel;
+    if (rmt_strip->bytes_per_pixel > 3) {
+        for (uint32_t i = 0; i < count; i++) {
+            buf[0] = rgb[1];
+            buf[1] = rgb[0];
+            buf[2] = rgb[2];
+            buf[3] = 0;
+            buf += 4;
+            rgb += 3;
+        }
+    } else {
+        // In thr order of GRB, as LED strip like WS2812 sends out pixels in this order
+        for (uint32_t i = 0; i < count; i++) {
+            buf[0] = rgb[1];
+            buf[1] = rgb[0];
+            buf[2] = rgb[2];
+            buf += 3;
+            rgb += 3;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_set_pixel_rgbw(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(index < rmt_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(rmt_strip->bytes_per_pixel == 4, ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    uint8_t *buf_start = rmt_strip->pixel_buf + index * 4;
+    // SK6812 component order is GRBW
+    *buf_start = green & 0xFF;
+    *++buf_start = red & 0xFF;
+    *++buf_start = blue & 0xFF;
+    *++buf_start = white & 0xFF;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_refresh(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    rmt_transmit_config_t tx_conf = {
+        .loop_count = 0,
+    };
+
+    if (rmt_strip->with_symbol_cache) {
+        ESP_RETURN_ON_ERROR(rmt_led_strip_encoder_update(rmt_strip->strip_encoder, rmt_strip->pixel_buf,
+                                                         rmt_strip->strip_len * rmt_strip->bytes_per_pixel), TAG, "encode pixels failed");
+    }
+    ESP_RETURN_ON_ERROR(rmt_enable(rmt_strip->rmt_chan), TAG, "enable RMT channel failed");
+    ESP_RETURN_ON_ERROR(rmt_transmit(rmt_strip->rmt_chan, rmt_strip->strip_encoder, rmt_strip->pixel_buf,
+                                     rmt_strip->strip_len * rmt_strip->bytes_per_pixel, &tx_conf), TAG, "transmit pixels by RMT failed");
+    ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(rmt_strip->rmt_chan, -1), TAG, "flush RMT channel failed");
+    ESP_RETURN_ON_ERROR(rmt_disable(rmt_strip->rmt_chan), TAG, "disable RMT channel failed");
+    return ESP_OK;
+}
+
+static bool IRAM_ATTR led_strip_rmt_on_trans_done(rmt_channel_handle_t tx_chan, const rmt_tx_done_event_data_t *edata, void *user_ctx)
+{
+    led_strip_rmt_obj *rmt_strip = (led_strip_rmt_obj *)user_ctx;
+    BaseType_t high_task_wakeup = pdFALSE;
+    bool need_yield = false;
+    xSemaphoreGiveFromISR(rmt_strip->refresh_done_sem, &high_task_wakeup);
+    if (rmt_strip->on_refresh_done) {
+        need_yield = rmt_strip->on_refresh_done(&rmt_strip->base, rmt_strip->user_ctx);
+    }
+    return need_yield || high_task_wakeup == pdTRUE;
+}
+
+static esp_err_t led_strip_rmt_wait_refresh_done(led_strip_t *strip, int32_t timeout_ms)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    if (!rmt_strip->in_flight) {
+        return ESP_OK;
+    }
+    TickType_t ticks = timeout_ms < 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    ESP_RETURN_ON_FALSE(xSemaphoreTake(rmt_strip->refresh_done_sem, ticks) == pdTRUE, ESP_ERR_TIMEOUT, TAG, "wait for refresh done timeout");
+    rmt_strip->in_flight = false;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_refresh_async(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    size_t buf_size = rmt_strip->strip_len * rmt_strip->bytes_per_pixel;
+    rmt_transmit_config_t tx_conf = {
+        .loop_count = 0,
+    };
+
+    // the previous front buffer becomes the new back buffer, so it must be off the wire first
+    ESP_RETURN_ON_ERROR(led_strip_rmt_wait_refresh_done(strip, -1), TAG, "wait for previous frame failed");
+    uint8_t *frame = rmt_strip->pixel_buf;
+    rmt_strip->pixel_buf = rmt_strip->front_buf;
+    rmt_strip->front_buf = frame;
+    // start the back buffer from the frame just submitted, so callers can keep doing partial updates
+    memcpy(rmt_strip->pixel_buf, rmt_strip->front_buf, buf_size);
+    if (rmt_strip->with_symbol_cache) {
+        ESP_RETURN_ON_ERROR(rmt_led_strip_encoder_update(rmt_strip->strip_encoder, rmt_strip->front_buf, buf_size), TAG, "encode pixels failed");
+    }
+
+    rmt_strip->in_flight = true;
+    esp_err_t ret = rmt_transmit(rmt_strip->rmt_chan, rmt_strip->strip_encoder, rmt_strip->front_buf, buf_size, &tx_conf);
+    if (ret != ESP_OK) {
+        rmt_strip->in_flight = false;
+        ESP_LOGE(TAG, "transmit pixels by RMT failed");
+    }
+    return ret;
+}
+
+static esp_err_t led_strip_rmt_refresh_double_buffer(led_strip_t *strip)
+{
+    ESP_RETURN_ON_ERROR(led_strip_rmt_refresh_async(strip), TAG, "refresh failed");
+    return led_strip_rmt_wait_refresh_done(strip, -1);
+}
+
+static esp_err_t led_strip_rmt_clear(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    // Write zero to turn off all leds
+    memset(rmt_strip->pixel_buf, 0, rmt_strip->strip_len * rmt_strip->bytes_per_pixel);
+    return strip->refresh(strip);
+}
+
+static esp_err_t led_strip_rmt_del(led_strip_t *strip)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    if (rmt_strip->double_buffer) {
+        ESP_RETURN_ON_ERROR(led_strip_rmt_wait_refresh_done(strip, -1), TAG, "wait for refresh done failed");
+        ESP_RETURN_ON_ERROR(rmt_disable(rmt_strip->rmt_chan), TAG, "disable RMT channel failed");
+    }
+    ESP_RETURN_ON_ERROR(rmt_del_channel(rmt_strip->rmt_chan), TAG, "delete RMT channel failed");
+    ESP_RETURN_ON_ERROR(rmt_del_encoder(rmt_strip->strip_encoder), TAG, "delete strip encoder failed");
+    if (rmt_strip->refresh_done_sem) {
+        vSemaphoreDelete(rmt_strip->refresh_done_sem);
+    }
+    free(rmt_strip);
+    return ESP_OK;
+}
+
+esp_err_t led_strip_rmt_get_encoder_stats(led_strip_handle_t strip, led_strip_rmt_encoder_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(strip && stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    // only strips created by led_strip_new_rmt_device are embedded in a led_strip_rmt_obj
+    ESP_RETURN_ON_FALSE(strip->del == led_strip_rmt_del, ESP_ERR_INVALID_ARG, TAG, "not an RMT strip");
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    return rmt_led_strip_encoder_get_stats(rmt_strip->strip_encoder, stats);
+}
+
+esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const led_strip_rmt_config_t *rmt_config, led_strip_handle_t *ret_strip)
+{
+    led_strip_rmt_obj *rmt_strip = NULL;
+    esp_err_t ret = ESP_OK;
+    ESP_GOTO_ON_FALSE(led_config && rmt_config && ret_strip, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    ESP_GOTO_ON_FALSE(led_config->led_pixel_format < LED_PIXEL_FORMAT_INVALID, ESP_ERR_INVALID_ARG, err, TAG, "invalid led_pixel_format");
+    uint8_t bytes_per_pixel = 3;
+    if (led_config->led_pixel_format == LED_PIXEL_FORMAT_GRBW) {
+        bytes_per_pixel = 4;
+    } else if (led_config->led_pixel_format == LED_PIXEL_FORMAT_GRB) {
+        bytes_per_pixel = 3;
+    } else {
+        assert(false);
+    }
+    size_t buf_size = led_config->max_leds * bytes_per_pixel;
+    // double buffer mode needs a second pixel buffer for the frame in flight
+    size_t buf_num = rmt_config->flags.double_buffer ? 2 : 1;
+    rmt_strip = calloc(1, sizeof(led_strip_rmt_obj) + buf_size * buf_num);
+    ESP_GOTO_ON_FALSE(rmt_strip, ESP_ERR_NO_MEM, err, TAG, "no mem for rmt strip");
+    rmt_strip->pixel_buf = rmt_strip->buffers;
+    uint32_t resolution = rmt_config->resolution_hz ? rmt_config->resolution_hz : LED_STRIP_RMT_DEFAULT_RESOLUTION;
+
+    // for backward compatibility, if the user does not set the clk_src, use the default value
+    rmt_clock_source_t clk_src = RMT_CLK_SRC_DEFAULT;
+    if (rmt_config->clk_src) {
+        clk_src = rmt_config->clk_src;
+    }
+    size_t mem_block_symbols = LED_STRIP_RMT_DEFAULT_MEM_BLOCK_SYMBOLS;
+    // override the default value if the user sets it
+    if (rmt_config->mem_block_symbols) {
+        mem_block_symbols = rmt_config->mem_block_symbols;
+    }
+    rmt_tx_channel_config_t rmt_chan_config = {
+        .clk_src = clk_src,
+        .gpio_num = led_config->strip_gpio_num,
+        .mem_block_symbols = mem_block_symbols,
+        .resolution_hz = resolution,
+        .trans_queue_depth = LED_STRIP_RMT_DEFAULT_TRANS_QUEUE_SIZE,
+        .flags.with_dma = rmt_config->flags.with_dma,
+        .flags.invert_out = led_config->flags.invert_out,
+    };
+    ESP_GOTO_ON_ERROR(rmt_new_tx_channel(&rmt_chan_config, &rmt_strip->rmt_chan), err, TAG, "create RMT TX channel failed");
+
+    led_strip_encoder_config_t strip_encoder_conf = {
+        .resolution = resolution,
+        .led_model = led_config->led_model,
+        .symbol_cache_size = rmt_config->flags.with_symbol_cache ? buf_size : 0,
+    };
+    ESP_GOTO_ON_ERROR(rmt_new_led_strip_encoder(&strip_encoder_conf, &rmt_strip->strip_encoder), err, TAG, "create LED strip encoder failed");
+
+    if (rmt_config->flags.double_buffer) {
+        rmt_strip->front_buf = rmt_strip->buffers + buf_size;
+        rmt_strip->refresh_done_sem = xSemaphoreCreateBinary();
+        ESP_GOTO_ON_FALSE(rmt_strip->refresh_done_sem, ESP_ERR_NO_MEM, err, TAG, "no mem for refresh done semaphore");
+        rmt_strip->on_refresh_done = rmt_config->on_refresh_done;
+        rmt_strip->user_ctx = rmt_config->user_ctx;
+        rmt_tx_event_callbacks_t cbs = {
+            .on_trans_done = led_strip_rmt_on_trans_done,
+        };
+        ESP_GOTO_ON_ERROR(rmt_tx_register_event_callbacks(rmt_strip->rmt_chan, &cbs, rmt_strip), err, TAG, "register RMT callbacks failed");
+        // the channel stays enabled between frames, saving the enable/disable round trip on every refresh
+        ESP_GOTO_ON_ERROR(rmt_enable(rmt_strip->rmt_chan), err, TAG, "enable RMT channel failed");
+        rmt_strip->double_buffer = true;
+    }
+
+    rmt_strip->with_symbol_cache = rmt_config->flags.with_symbol_cache;
+    rmt_strip->bytes_per_pixel = bytes_per_pixel;
+    rmt_strip->strip_len = led_config->max_leds;
+    rmt_strip->base.set_pixel = led_strip_rmt_set_pixel;
+    rmt_strip->base.set_pixel_rgbw = led_strip_rmt_set_pixel_rgbw;
+    rmt_strip->base.set_pixels = led_strip_rmt_set_pixels;
+    if (rmt_strip->double_buffer) {
+        rmt_strip->base.refresh = led_strip_rmt_refresh_double_buffer;
+        rmt_strip->base.refresh_async = led_strip_rmt_refresh_async;
+        rmt_strip->base.wait_refresh_done = led_strip_rmt_wait_refresh_done;
+    } else {
+        rmt_strip->base.refresh = led_strip_rmt_refresh;
+    }
+    rmt_strip->base.clear = led_strip_rmt_clear;
+    rmt_strip->base.del = led_strip_rmt_del;
+
+    *ret_strip = &rmt_strip->base;
+    return ESP_OK;
+err:
+    if (rmt_strip) {
+        if (rmt_strip->rmt_chan) {
+            rmt_del_channel(rmt_strip->rmt_chan);
+        }
+        if (rmt_strip->strip_encoder) {
+            rmt_del_encoder(rmt_strip->strip_encoder);
+        }
+        if (rmt_strip->refresh_done_sem) {
+            vSemaphoreDelete(rmt_strip->refresh_done_sem);
+        }
+        free(rmt_strip);
+    }
+    return ret;
+}
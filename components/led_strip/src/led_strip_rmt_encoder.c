@@ -0,0 +1,226 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_check.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "led_strip_rmt_encoder.h"
+
+static const char *TAG = "led_rmt_encoder";
+
+typedef struct {
+    rmt_encoder_t base;
+    rmt_encoder_t *bytes_encoder;
+    rmt_encoder_t *copy_encoder;
+    int state;
+    rmt_symbol_word_t reset_code;
+    rmt_symbol_word_t (*byte_symbols)[8]; // lookup table from a byte value to its 8 RMT symbols, MSB first
+    rmt_symbol_word_t *symbol_cache;      // pre-encoded frame, 8 symbols per byte
+    uint8_t *cached_data;                 // the bytes currently held in symbol_cache
+    size_t cache_size;                    // capacity of the cache, in bytes
+    size_t cached_size;                   // size of the frame in the cache, 0 if the cache is empty
+    led_strip_rmt_encoder_stats_t stats;
+} rmt_led_strip_encoder_t;
+
+static size_t rmt_encode_led_strip(rmt_encoder_t *encoder, rmt_channel_handle_t channel, const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state)
+{
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    rmt_encoder_handle_t bytes_encoder = led_encoder->bytes_encoder;
+    rmt_encoder_handle_t copy_encoder = led_encoder->copy_encoder;
+    rmt_encode_state_t session_state = 0;
+    rmt_encode_state_t state = 0;
+    size_t encoded_symbols = 0;
+    switch (led_encoder->state) {
+    case 0: // send RGB data
+        if (led_encoder->symbol_cache) {
+            // the frame has been pre-encoded by rmt_led_strip_encoder_update, just copy the symbols
+            encoded_symbols += copy_encoder->encode(copy_encoder, channel, led_encoder->symbol_cache,
+                                                    led_encoder->cached_size * 8 * sizeof(rmt_symbol_word_t), &session_state);
+        } else {
+            encoded_symbols += bytes_encoder->encode(bytes_encoder, channel, primary_data, data_size, &session_state);
+        }
+        if (session_state & RMT_ENCODING_COMPLETE) {
+            led_encoder->state = 1; // switch to next state when current encoding session finished
+        }
+        if (session_state & RMT_ENCODING_MEM_FULL) {
+            state |= RMT_ENCODING_MEM_FULL;
+            goto out; // yield if there's no free space for encoding artifacts
+        }
+    // fall-through
+    case 1: // send reset code
+        encoded_symbols += copy_encoder->encode(copy_encoder, channel, &led_encoder->reset_code,
+                                                sizeof(led_encoder->reset_code), &session_state);
+        if (session_state & RMT_ENCODING_COMPLETE) {
+            led_encoder->state = 0; // back to the initial encoding session
+            state |= RMT_ENCODING_COMPLETE;
+        }
+        if (session_state & RMT_ENCODING_MEM_FULL) {
+            state |= RMT_ENCODING_MEM_FULL;
+            goto out; // yield if there's no free space for encoding artifacts
+        }
+    }
+out:
+    *ret_state = state;
+    return encoded_symbols;
+}
+
+static esp_err_t rmt_del_led_strip_encoder(rmt_encoder_t *encoder)
+{
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    rmt_del_encoder(led_encoder->bytes_encoder);
+    rmt_del_encoder(led_encoder->copy_encoder);
+    free(led_encoder->byte_symbols);
+    free(led_encoder->symbol_cache);
+    free(led_encoder->cached_data);
+    free(led_encoder);
+    return ESP_OK;
+}
+
+static esp_err_t rmt_led_strip_encoder_reset(rmt_encoder_t *encoder)
+{
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    rmt_encoder_reset(led_encoder->bytes_encoder);
+    rmt_encoder_reset(led_encoder->copy_encoder);
+    led_encoder->state = 0;
+    return ESP_OK;
+}
+
+esp_err_t rmt_led_strip_encoder_update(rmt_encoder_handle_t encoder, const uint8_t *data, size_t data_size)
+{
+    ESP_RETURN_ON_FALSE(encoder && data, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    ESP_RETURN_ON_FALSE(led_encoder->symbol_cache, ESP_ERR_INVALID_STATE, TAG, "symbol cache not enabled");
+    ESP_RETURN_ON_FALSE(data_size <= led_encoder->cache_size, ESP_ERR_INVALID_ARG, TAG, "frame larger than symbol cache");
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    uint32_t encoded = 0;
+    if (data_size != led_encoder->cached_size) {
+        // nothing valid to compare against, encode the whole frame
+        for (size_t i = 0; i < data_size; i++) {
+            memcpy(&led_encoder->symbol_cache[i * 8], led_encoder->byte_symbols[data[i]], 8 * sizeof(rmt_symbol_word_t));
+        }
+        encoded = data_size;
+    } else {
+        for (size_t i = 0; i < data_size; i++) {
+            if (data[i] != led_encoder->cached_data[i]) {
+                memcpy(&led_encoder->symbol_cache[i * 8], led_encoder->byte_symbols[data[i]], 8 * sizeof(rmt_symbol_word_t));
+                encoded++;
+            }
+        }
+    }
+    memcpy(led_encoder->cached_data, data, data_size);
+    led_encoder->cached_size = data_size;
+
+    uint32_t cycles = esp_cpu_get_cycle_count() - start;
+    led_encoder->stats.frames++;
+    led_encoder->stats.last_encode_cycles = cycles;
+    if (cycles > led_encoder->stats.max_encode_cycles) {
+        led_encoder->stats.max_encode_cycles = cycles;
+    }
+    led_encoder->stats.last_bytes_encoded = encoded;
+    return ESP_OK;
+}
+
+esp_err_t rmt_led_strip_encoder_get_stats(rmt_encoder_handle_t encoder, led_strip_rmt_encoder_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(encoder && stats, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    rmt_led_strip_encoder_t *led_encoder = __containerof(encoder, rmt_led_strip_encoder_t, base);
+    *stats = led_encoder->stats;
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_led_strip_encoder(const led_strip_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder)
+{
+    esp_err_t ret = ESP_OK;
+    rmt_led_strip_encoder_t *led_encoder = NULL;
+    ESP_GOTO_ON_FALSE(config && ret_encoder, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    ESP_GOTO_ON_FALSE(config->led_model < LED_MODEL_INVALID, ESP_ERR_INVALID_ARG, err, TAG, "invalid led model");
+    led_encoder = calloc(1, sizeof(rmt_led_strip_encoder_t));
+    ESP_GOTO_ON_FALSE(led_encoder, ESP_ERR_NO_MEM, err, TAG, "no mem for led strip encoder");
+    led_encoder->base.encode = rmt_encode_led_strip;
+    led_encoder->base.del = rmt_del_led_strip_encoder;
+    led_encoder->base.reset = rmt_led_strip_encoder_reset;
+    rmt_bytes_encoder_config_t bytes_encoder_config;
+    if (config->led_model == LED_MODEL_SK6812) {
+        bytes_encoder_config = (rmt_bytes_encoder_config_t) {
+            .bit0 = {
+                .level0 = 1,
+                .duration0 = 0.3 * config->resolution / 1000000, // T0H=0.3us
+                .level1 = 0,
+                .duration1 = 0.9 * config->resolution / 1000000, // T0L=0.9us
+            },
+            .bit1 = {
+                .level0 = 1,
+                .duration0 = 0.6 * config->resolution / 1000000, // T1H=0.6us
+                .level1 = 0,
+                .duration1 = 0.6 * config->resolution / 1000000, // T1L=0.6us
+            },
+            .flags.msb_first = 1 // SK6812 transfer bit order: G7...G0R7...R0B7...B0(W7...W0)
+        };
+    } else if (config->led_model == LED_MODEL_WS2812) {
+        // different led strip might have its own timing requirements, following parameter is for WS2812
+        bytes_encoder_config = (rmt_bytes_encoder_config_t) {
+            .bit0 = {
+                .level0 = 1,
+                .duration0 = 0.3 * config->resolution / 1000000, // T0H=0.3us
+                .level1 = 0,
+                .duration1 = 0.9 * config->resolution / 1000000, // T0L=0.9us
+            },
+            .bit1 = {
+                .level0 = 1,
+                .duration0 = 0.9 * config->resolution / 1000000, // T1H=0.9us
+                .level1 = 0,
+                .duration1 = 0.3 * config->resolution / 1000000, // T1L=0.3us
+            },
+            .flags.msb_first = 1 // WS2812 transfer bit order: G7...G0R7...R0B7...B0
+        };
+    } else {
+        assert(false);
+    }
+    ESP_GOTO_ON_ERROR(rmt_new_bytes_encoder(&bytes_encoder_config, &led_encoder->bytes_encoder), err, TAG, "create bytes encoder failed");
+    if (config->symbol_cache_size) {
+        led_encoder->byte_symbols = calloc(256, sizeof(*led_encoder->byte_symbols));
+        // the cache is read from the RMT ISR while refilling, keep it in internal memory
+        led_encoder->symbol_cache = heap_caps_calloc(config->symbol_cache_size * 8, sizeof(rmt_symbol_word_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        led_encoder->cached_data = calloc(1, config->symbol_cache_size);
+        ESP_GOTO_ON_FALSE(led_encoder->byte_symbols && led_encoder->symbol_cache && led_encoder->cached_data, ESP_ERR_NO_MEM, err, TAG, "no mem for symbol cache");
+        led_encoder->cache_size = config->symbol_cache_size;
+        // same bit order as the bytes encoder: MSB first
+        for (int value = 0; value < 256; value++) {
+            for (int bit = 0; bit < 8; bit++) {
+                led_encoder->byte_symbols[value][bit] = (value & (0x80 >> bit)) ? bytes_encoder_config.bit1 : bytes_encoder_config.bit0;
+            }
+        }
+    }
+    rmt_copy_encoder_config_t copy_encoder_config = {};
+    ESP_GOTO_ON_ERROR(rmt_new_copy_encoder(&copy_encoder_config, &led_encoder->copy_encoder), err, TAG, "create copy encoder failed");
+
+    uint32_t reset_ticks = config->resolution / 1000000 * 280 / 2; // reset code duration defaults to 280us to accomodate WS2812B-V5
+    led_encoder->reset_code = (rmt_symbol_word_t) {
+        .level0 = 0,
+        .duration0 = reset_ticks,
+        .level1 = 0,
+        .duration1 = reset_ticks,
+    };
+    *ret_encoder = &led_encoder->base;
+    return ESP_OK;
+err:
+    if (led_encoder) {
+        if (led_encoder->bytes_encoder) {
+            rmt_del_encoder(led_encoder->bytes_encoder);
+        }
+        if (led_encoder->copy_encoder) {
+            rmt_del_encoder(led_encoder->copy_encoder);
+        }
+        free(led_encoder->byte_symbols);
+        free(led_encoder->symbol_cache);
+        free(led_encoder->cached_data);
+        free(led_encoder);
+    }
+    return ret;
+}
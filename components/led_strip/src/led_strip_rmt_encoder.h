@@ -0,0 +1,67 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "driver/rmt_encoder.h"
+#include "led_strip_types.h"
+#include "led_strip_rmt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Type of led strip encoder configuration
+ */
+typedef struct {
+    uint32_t resolution;   /*!< Encoder resolution, in Hz */
+    led_model_t led_model; /*!< LED model */
+    size_t symbol_cache_size; /*!< Largest frame in bytes kept pre-encoded as RMT symbols, 0 to encode bit by bit on every transmission */
+} led_strip_encoder_config_t;
+
+/**
+ * @brief Create RMT encoder for encoding LED strip pixels into RMT symbols
+ *
+ * @param[in] config Encoder configuration
+ * @param[out] ret_encoder Returned encoder handle
+ * @return
+ *      - ESP_ERR_INVALID_ARG for any invalid arguments
+ *      - ESP_ERR_NO_MEM out of memory when creating led strip encoder
+ *      - ESP_OK if creating encoder successfully
+ */
+esp_err_t rmt_new_led_strip_encoder(const led_strip_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder);
+
+/**
+ * @brief Pre-encode a frame into the symbol cache, only the bytes that changed since the last call are re-encoded
+ *
+ * @note Only valid for encoders created with a non-zero `symbol_cache_size`.
+ *       Must be called with the exact buffer passed to the following `rmt_transmit`, and never while a transmission is in flight.
+ *
+ * @param[in] encoder Encoder handle returned by `rmt_new_led_strip_encoder`
+ * @param[in] data Pixel bytes in wire order
+ * @param[in] data_size Size of the pixel data, in bytes
+ * @return
+ *      - ESP_ERR_INVALID_ARG for any invalid arguments
+ *      - ESP_ERR_INVALID_STATE if the encoder has no symbol cache
+ *      - ESP_OK if the frame is encoded successfully
+ */
+esp_err_t rmt_led_strip_encoder_update(rmt_encoder_handle_t encoder, const uint8_t *data, size_t data_size);
+
+/**
+ * @brief Get the symbol cache statistics of the encoder
+ *
+ * @param[in] encoder Encoder handle returned by `rmt_new_led_strip_encoder`
+ * @param[out] stats Returned statistics
+ * @return
+ *      - ESP_ERR_INVALID_ARG for any invalid arguments
+ *      - ESP_OK if the statistics are returned successfully
+ */
+esp_err_t rmt_led_strip_encoder_get_stats(rmt_encoder_handle_t encoder, led_strip_rmt_encoder_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,35 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "led_strip_spi_encoder.h"
+
+uint8_t led_strip_spi_lut[256][SPI_BYTES_PER_COLOR_BYTE];
+static bool led_strip_spi_lut_ready = false;
+
+void led_strip_spi_encoder_init(void)
+{
+    if (led_strip_spi_lut_ready) {
+        return;
+    }
+    for (int value = 0; value < 256; value++) {
+        led_strip_spi_encode_bit(value, led_strip_spi_lut[value]);
+    }
+    led_strip_spi_lut_ready = true;
+}
+
+void led_strip_spi_encode_pixels(uint8_t *buf, const uint8_t *rgb, uint32_t count, bool with_white)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        led_strip_spi_encode_byte(rgb[1], buf);
+        led_strip_spi_encode_byte(rgb[0], buf + SPI_BYTES_PER_COLOR_BYTE);
+        led_strip_spi_encode_byte(rgb[2], buf + SPI_BYTES_PER_COLOR_BYTE * 2);
+        buf += SPI_BYTES_PER_COLOR_BYTE * 3;
+        if (with_white) {
+            led_strip_spi_encode_byte(0, buf);
+            buf += SPI_BYTES_PER_COLOR_BYTE;
+        }
+        rgb += 3;
+    }
+}
@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "esp_bit_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SPI_BYTES_PER_COLOR_BYTE 3
+#define SPI_BITS_PER_COLOR_BYTE (SPI_BYTES_PER_COLOR_BYTE * 8)
+
+// lookup table from a color byte to its 3 bytes SPI pattern, filled once by led_strip_spi_encoder_init
+extern uint8_t led_strip_spi_lut[256][SPI_BYTES_PER_COLOR_BYTE];
+
+// please make sure to zero-initialize the buf before calling this function
+static inline void led_strip_spi_encode_bit(uint8_t data, uint8_t *buf)
+{
+    // Each color of 1 bit is represented by 3 bits of SPI, low_level:100 ,high_level:110
+    // So a color byte occupies 3 bytes of SPI.
+    *(buf + 2) |= data & BIT(0) ? BIT(2) | BIT(1) : BIT(2);
+    *(buf + 2) |= data & BIT(1) ? BIT(5) | BIT(4) : BIT(5);
+    *(buf + 2) |= data & BIT(2) ? BIT(7) : 0x00;
+    *(buf + 1) |= BIT(0);
+    *(buf + 1) |= data & BIT(3) ? BIT(3) | BIT(2) : BIT(3);
+    *(buf + 1) |= data & BIT(4) ? BIT(6) | BIT(5) : BIT(6);
+    *(buf + 0) |= data & BIT(5) ? BIT(1) | BIT(0) : BIT(1);
+    *(buf + 0) |= data & BIT(6) ? BIT(4) | BIT(3) : BIT(4);
+    *(buf + 0) |= data & BIT(7) ? BIT(7) | BIT(6) : BIT(7);
+}
+
+/**
+ * @brief Fill the lookup table from `led_strip_spi_encode_bit`, only the first call does the work
+ */
+void led_strip_spi_encoder_init(void);
+
+static inline void led_strip_spi_encode_byte(uint8_t data, uint8_t *buf)
+{
+    memcpy(buf, led_strip_spi_lut[data], SPI_BYTES_PER_COLOR_BYTE);
+}
+
+/**
+ * @brief Encode a span of RGB pixels in wire order (GRB, or GRBW with white = 0)
+ *
+ * @param[out] buf SPI pattern of the first pixel, 9 bytes per pixel (12 with white)
+ * @param[in] rgb Pixels, 3 bytes each in R, G, B order
+ * @param[in] count Number of pixels
+ * @param[in] with_white Append a zero white channel to every pixel
+ */
+void led_strip_spi_encode_pixels(uint8_t *buf, const uint8_t *rgb, uint32_t count, bool with_white);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,160 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_bit_defs.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "boot_seq.h"
+
+static const char *TAG = "boot_seq";
+
+#define BOOT_STAGE_DEFAULT_STACK 4096
+#define BOOT_FAIL_SHIFT BOOT_SEQ_MAX_STAGES
+
+typedef struct {
+    const boot_stage_t *stage;
+    int index;
+    int64_t start_us;
+    int64_t end_us;
+    esp_err_t err;
+    boot_stage_state_t state;
+    bool background;            // 自身或某个依赖是后台阶段
+} boot_stage_run_t;
+
+static boot_stage_run_t runs[BOOT_SEQ_MAX_STAGES];
+static int run_count;
+static int64_t boot_start_us;
+static EventGroupHandle_t stage_events;
+
+static void boot_stage_task(void *arg) {
+    boot_stage_run_t *run = arg;
+    const boot_stage_t *stage = run->stage;
+    EventBits_t deps = stage->deps;
+    EventBits_t failed_deps = deps << BOOT_FAIL_SHIFT;
+
+    // 每个依赖结束时都会唤醒一次, 直到全部完成或其中一个失败
+    EventBits_t bits = xEventGroupGetBits(stage_events);
+    while ((bits & deps) != deps && (bits & failed_deps) == 0) {
+        bits = xEventGroupWaitBits(stage_events, deps | failed_deps, pdFALSE, pdFALSE, portMAX_DELAY);
+    }
+
+    run->start_us = esp_timer_get_time();
+    if (bits & failed_deps) {
+        run->state = BOOT_STAGE_SKIPPED;
+        run->end_us = run->start_us;
+        ESP_LOGW(TAG, "%s skipped, a dependency did not finish", stage->name);
+    } else {
+        run->err = stage->fn(stage->arg);
+        run->end_us = esp_timer_get_time();
+        run->state = run->err == ESP_OK ? BOOT_STAGE_DONE : BOOT_STAGE_FAILED;
+        if (run->err == ESP_OK) {
+            ESP_LOGI(TAG, "%s done in %" PRId64 " ms", stage->name, (run->end_us - run->start_us) / 1000);
+        } else {
+            ESP_LOGE(TAG, "%s failed: %s", stage->name, esp_err_to_name(run->err));
+        }
+    }
+    xEventGroupSetBits(stage_events, run->state == BOOT_STAGE_DONE ? BIT(run->index) : BIT(run->index + BOOT_FAIL_SHIFT));
+    vTaskDelete(NULL);
+}
+
+esp_err_t boot_seq_run(const boot_stage_t *stages, int count) {
+    ESP_RETURN_ON_FALSE(stages && count > 0 && count <= BOOT_SEQ_MAX_STAGES, ESP_ERR_INVALID_ARG, TAG, "invalid stages");
+    for (int i = 0; i < count; i++) {
+        // 只允许依赖排在前面的阶段, 保证不会出现循环依赖
+        ESP_RETURN_ON_FALSE(stages[i].fn && (stages[i].deps >> i) == 0, ESP_ERR_INVALID_ARG, TAG,
+                            "invalid stage %d", i);
+    }
+    if (stage_events == NULL) {
+        stage_events = xEventGroupCreate();
+        ESP_RETURN_ON_FALSE(stage_events, ESP_ERR_NO_MEM, TAG, "no mem for event group");
+    }
+    xEventGroupClearBits(stage_events, (1U << (2 * BOOT_SEQ_MAX_STAGES)) - 1);
+
+    boot_start_us = esp_timer_get_time();
+    run_count = count;
+    EventBits_t all = 0;
+    UBaseType_t priority = uxTaskPriorityGet(NULL);
+    for (int i = 0; i < count; i++) {
+        runs[i] = (boot_stage_run_t) {
+            .stage = &stages[i],
+            .index = i,
+            .state = BOOT_STAGE_PENDING,
+            .background = stages[i].background,
+        };
+        for (int d = 0; d < i; d++) {
+            if ((stages[i].deps & BIT(d)) && runs[d].background) {
+                runs[i].background = true;
+            }
+        }
+        uint32_t stack = stages[i].stack_size ? stages[i].stack_size : BOOT_STAGE_DEFAULT_STACK;
+        if (xTaskCreate(boot_stage_task, stages[i].name, stack, &runs[i], priority, NULL) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create task for %s", stages[i].name);
+            runs[i].state = BOOT_STAGE_FAILED;
+            runs[i].err = ESP_ERR_NO_MEM;
+            runs[i].start_us = runs[i].end_us = esp_timer_get_time();
+            xEventGroupSetBits(stage_events, BIT(i + BOOT_FAIL_SHIFT));
+        }
+        if (!runs[i].background) {
+            all |= BIT(i);
+        }
+    }
+
+    // 每个阶段结束时置位完成位或失败位, 等到所有前台阶段都有结果
+    EventBits_t bits = 0;
+    while (((bits | (bits >> BOOT_FAIL_SHIFT)) & all) != all) {
+        bits = xEventGroupWaitBits(stage_events, all | (all << BOOT_FAIL_SHIFT), pdFALSE, pdFALSE, portMAX_DELAY);
+    }
+    return (bits & all) == all ? ESP_OK : ESP_FAIL;
+}
+
+boot_stage_state_t boot_seq_get_state(int stage) {
+    if (stage < 0 || stage >= run_count) {
+        return BOOT_STAGE_PENDING;
+    }
+    return runs[stage].state;
+}
+
+void boot_seq_report(void) {
+    static const char *state_names[] = { "pending", "done", "FAILED", "skipped" };
+    int last = -1;
+    for (int i = 0; i < run_count; i++) {
+        const boot_stage_run_t *run = &runs[i];
+        if (run->state == BOOT_STAGE_PENDING) {
+            ESP_LOGI(TAG, "%-12s %s", run->stage->name, run->background ? "running in the background" : "pending");
+            continue;
+        }
+        ESP_LOGI(TAG, "%-12s start %6" PRId64 " ms, %6" PRId64 " ms, %s%s", run->stage->name,
+                 (run->start_us - boot_start_us) / 1000, (run->end_us - run->start_us) / 1000, state_names[run->state],
+                 run->background ? " (background)" : "");
+        // 就绪时间只由前台阶段决定
+        if (!run->background && (last < 0 || run->end_us > runs[last].end_us)) {
+            last = i;
+        }
+    }
+    if (last < 0) {
+        return;
+    }
+
+    // 关键路径: 从最后结束的阶段开始, 每次回溯到最晚结束的依赖
+    int path[BOOT_SEQ_MAX_STAGES];
+    int length = 0;
+    for (int i = last; i >= 0; ) {
+        path[length++] = i;
+        int next = -1;
+        for (int d = 0; d < i; d++) {
+            if ((runs[i].stage->deps & BIT(d)) && (next < 0 || runs[d].end_us > runs[next].end_us)) {
+                next = d;
+            }
+        }
+        i = next;
+    }
+    char text[160];
+    int pos = 0;
+    for (int i = length - 1; i >= 0 && pos < (int)sizeof(text); i--) {
+        pos += snprintf(text + pos, sizeof(text) - pos, i ? "%s -> " : "%s", runs[path[i]].stage->name);
+    }
+    ESP_LOGI(TAG, "Ready after %" PRId64 " ms, critical path: %s", (runs[last].end_us - boot_start_us) / 1000, text);
+}
@@ -0,0 +1,47 @@
+#ifndef BOOT_SEQ_H
+#define BOOT_SEQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// 事件组可用 24 位, 每个阶段占用完成和失败两位
+#define BOOT_SEQ_MAX_STAGES 12
+
+typedef esp_err_t (*boot_stage_fn_t)(void *arg);
+
+/**
+ * @brief Boot stage description
+ */
+typedef struct {
+    const char *name;           /*!< Stage name used in the log and the timing report */
+    boot_stage_fn_t fn;         /*!< Initialisation function, runs in its own task */
+    void *arg;                  /*!< Argument passed to fn */
+    uint32_t deps;              /*!< Bit mask of the stage indices that must have finished first */
+    uint32_t stack_size;        /*!< Stack of the stage task, 0 for the default of 4096 bytes */
+    bool background;            /*!< Not part of the ready point, boot_seq_run does not wait for it. Stages that depend on it are background too */
+} boot_stage_t;
+
+/**
+ * @brief Boot stage result
+ */
+typedef enum {
+    BOOT_STAGE_PENDING,         /*!< Not finished yet */
+    BOOT_STAGE_DONE,            /*!< fn returned ESP_OK */
+    BOOT_STAGE_FAILED,          /*!< fn returned an error */
+    BOOT_STAGE_SKIPPED,         /*!< Not run because a dependency failed or was skipped */
+} boot_stage_state_t;
+
+// 每个阶段在各自的任务中运行, 依赖全部完成后立即开始, 没有依赖关系的阶段并行初始化
+// 某个阶段失败时只跳过依赖它的阶段, 其余阶段照常完成
+// 前台阶段全部结束 (启动就绪) 后返回, 有前台阶段失败或跳过时返回 ESP_FAIL
+// 后台阶段 (例如可能一直等待配网的 Wi-Fi) 在返回之后继续运行
+esp_err_t boot_seq_run(const boot_stage_t *stages, int count);
+
+boot_stage_state_t boot_seq_get_state(int stage);
+
+// 打印每个阶段的开始时间、耗时、结果, 以及决定就绪时间的前台关键路径
+// 尚未结束的后台阶段只列出名字
+void boot_seq_report(void);
+
+#endif // BOOT_SEQ_H
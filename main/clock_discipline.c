@@ -0,0 +1,126 @@
+#include <math.h>
+#include <stdbool.h>
+#include <sys/time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "clock_discipline.h"
+#include "clock_servo.h"
+
+static const char *TAG = "clock_discipline";
+
+#define NVS_NAMESPACE "clock"
+#define NVS_KEY_PPB   "drift_ppb"
+
+// 估计变化超过这个值才写 NVS, 减少 flash 磨损
+#define NVS_SAVE_THRESHOLD_PPM 0.5f
+
+static esp_timer_handle_t discipline_timer;
+static SemaphoreHandle_t adjtime_lock;
+static clock_discipline_stats_t discipline_stats;
+static float saved_ppm;
+static float pending_us;    // 不足 1 微秒的部分, 留到下一次
+
+static int64_t timeval_to_us(const struct timeval *tv)
+{
+    return (int64_t)tv->tv_sec * 1000000L + tv->tv_usec;
+}
+
+static void clock_discipline_adjtime(int64_t delta_us, bool replace)
+{
+    xSemaphoreTake(adjtime_lock, portMAX_DELAY);
+    if (!replace) {
+        struct timeval pending;
+        adjtime(NULL, &pending);
+        delta_us += timeval_to_us(&pending);
+    }
+    struct timeval delta = { .tv_sec = delta_us / 1000000L, .tv_usec = delta_us % 1000000L };
+    adjtime(&delta, NULL);
+    xSemaphoreGive(adjtime_lock);
+}
+
+void clock_discipline_adjtime_add(int64_t delta_us)
+{
+    clock_discipline_adjtime(delta_us, false);
+}
+
+void clock_discipline_adjtime_set(int64_t delta_us)
+{
+    clock_discipline_adjtime(delta_us, true);
+}
+
+// 每个周期按频率误差补偿这段时间内累积的漂移
+static void clock_discipline_timer_cb(void *arg)
+{
+    pending_us += discipline_stats.ppm * CONFIG_CLOCK_DISCIPLINE_PERIOD_S;
+    int64_t delta_us = (int64_t)pending_us;
+    if (delta_us == 0) {
+        return;
+    }
+    pending_us -= delta_us;
+    clock_discipline_adjtime_add(delta_us);
+    discipline_stats.corrections++;
+    discipline_stats.corrected_us += delta_us;
+}
+
+void clock_discipline_save(void)
+{
+    float ppm = discipline_stats.ppm;
+    if (fabsf(ppm - saved_ppm) < NVS_SAVE_THRESHOLD_PPM) {
+        return;
+    }
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    if (nvs_set_i32(handle, NVS_KEY_PPB, lroundf(ppm * 1000)) == ESP_OK && nvs_commit(handle) == ESP_OK) {
+        saved_ppm = ppm;
+        discipline_stats.nvs_writes++;
+    }
+    nvs_close(handle);
+}
+
+void clock_discipline_sample(int64_t residual_us, int64_t elapsed_us)
+{
+    if (elapsed_us <= 0) {
+        return;
+    }
+    discipline_stats.ppm = clock_servo_next_ppm(discipline_stats.ppm, residual_us, elapsed_us);
+    discipline_stats.samples++;
+    ESP_LOGI(TAG, "Residual %.2f ppm, estimate %.2f ppm",
+             (float)residual_us * 1e6f / (float)elapsed_us, discipline_stats.ppm);
+    // 这里运行在 SNTP 回调 (tcpip 线程) 中, 不写 flash, 由 clock_discipline_save 在显示任务中保存
+}
+
+esp_err_t clock_discipline_init(void)
+{
+    ESP_RETURN_ON_FALSE(discipline_timer == NULL, ESP_ERR_INVALID_STATE, TAG, "already initialized");
+    adjtime_lock = xSemaphoreCreateMutex();
+    ESP_RETURN_ON_FALSE(adjtime_lock, ESP_ERR_NO_MEM, TAG, "no mem for lock");
+
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        int32_t ppb = 0;
+        if (nvs_get_i32(handle, NVS_KEY_PPB, &ppb) == ESP_OK) {
+            discipline_stats.ppm = ppb / 1000.0f;
+            saved_ppm = discipline_stats.ppm;
+            ESP_LOGI(TAG, "Restored drift estimate %.3f ppm", discipline_stats.ppm);
+        }
+        nvs_close(handle);
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = clock_discipline_timer_cb,
+        .name = "clock_discipline",
+    };
+    ESP_RETURN_ON_ERROR(esp_timer_create(&timer_args, &discipline_timer), TAG, "create timer failed");
+    return esp_timer_start_periodic(discipline_timer, CONFIG_CLOCK_DISCIPLINE_PERIOD_S * 1000000LL);
+}
+
+void clock_discipline_get_stats(clock_discipline_stats_t *stats)
+{
+    *stats = discipline_stats;
+}
@@ -0,0 +1,40 @@
+#ifndef CLOCK_DISCIPLINE_H
+#define CLOCK_DISCIPLINE_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @brief Clock discipline statistics
+ */
+typedef struct {
+    float ppm;                  /*!< Current oscillator frequency error estimate, positive when the local clock runs slow */
+    uint32_t samples;           /*!< NTP samples folded into the estimate since boot */
+    uint32_t corrections;       /*!< Periodic slews applied since boot */
+    int64_t corrected_us;       /*!< Total time slewed by the discipline since boot, in microseconds */
+    uint32_t nvs_writes;        /*!< Times the estimate was written to NVS since boot */
+} clock_discipline_stats_t;
+
+// 从 NVS 读取上次保存的频率误差, 启动定期的 adjtime 微调
+// 需要在 nvs_flash_init 之后调用
+esp_err_t clock_discipline_init(void);
+
+// 对时时调用: residual_us 为扣除尚未完成的 adjtime 之后的剩余误差, elapsed_us 为距上一次对时的时间
+// 剩余误差说明当前估计仍有偏差, 按比例修正估计
+// 只更新内存中的估计, 可以在 SNTP 回调中调用
+void clock_discipline_sample(int64_t residual_us, int64_t elapsed_us);
+
+// 估计与上次保存的值相差超过阈值时写入 NVS, 会等待 flash 写入
+// 在普通任务中定期调用, 不要在 SNTP 回调或 esp_timer 回调中调用
+void clock_discipline_save(void);
+
+// 在尚未完成的 adjtime 上叠加一段调整, adjtime 会替换而不是累加未完成的部分
+void clock_discipline_adjtime_add(int64_t delta_us);
+
+// 用新的调整替换尚未完成的部分, 用于对时时的平滑校准
+// 两个函数与定时微调互斥, 不会互相覆盖
+void clock_discipline_adjtime_set(int64_t delta_us);
+
+void clock_discipline_get_stats(clock_discipline_stats_t *stats);
+
+#endif // CLOCK_DISCIPLINE_H
@@ -0,0 +1,149 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "clock_engine.h"
+
+static const char *TAG = "clock_engine";
+
+#define SECONDS_PER_DAY 86400
+
+// 时区规则切换时刻表, 覆盖 [table_start, table_end)
+static time_t transitions[CLOCK_ENGINE_MAX_TRANSITIONS];
+static int transition_count;
+static time_t table_start;
+static time_t table_end;
+
+// 最近一次换算的结果, 在 valid_until 之前可以直接递增
+static struct tm cached;
+static time_t cached_time;
+static time_t valid_until;
+static volatile bool cache_invalid = true;
+
+static clock_engine_stats_t engine_stats;
+
+// 公历日期到 1970-01-01 起的天数
+static int64_t days_from_civil(int64_t y, int m, int d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// 时区规则在 t 时刻的状态: UTC 偏移和夏令时标志, 两者任一变化即为一次切换
+static int64_t clock_zone_state(time_t t) {
+    struct tm tm;
+    localtime_r(&t, &tm);
+    int64_t local = days_from_civil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday) * SECONDS_PER_DAY
+                    + tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec;
+    return (local - t) * 2 + (tm.tm_isdst > 0);
+}
+
+// 按天扫描找出有变化的一天, 再在这一天内二分查找到具体的秒
+static void clock_build_transitions(time_t from) {
+    transition_count = 0;
+    table_start = from;
+    table_end = from + (time_t)CLOCK_ENGINE_TRANSITION_YEARS * 366 * SECONDS_PER_DAY;
+    int64_t state = clock_zone_state(from);
+    for (time_t t = from + SECONDS_PER_DAY; t < table_end; t += SECONDS_PER_DAY) {
+        int64_t next_state = clock_zone_state(t);
+        if (next_state == state) {
+            continue;
+        }
+        time_t lo = t - SECONDS_PER_DAY;
+        time_t hi = t;
+        while (hi - lo > 1) {
+            time_t mid = lo + (hi - lo) / 2;
+            if (clock_zone_state(mid) == state) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        if (transition_count == CLOCK_ENGINE_MAX_TRANSITIONS) {
+            // 表满了, 提前结束覆盖范围, 到时再重新计算
+            table_end = hi;
+            break;
+        }
+        transitions[transition_count++] = hi;
+        state = next_state;
+    }
+    engine_stats.transitions = transition_count;
+    ESP_LOGD(TAG, "%d zone transitions until %lld", transition_count, (long long)table_end);
+}
+
+static void clock_full_conversion(time_t now) {
+    cache_invalid = false;
+    if (now < table_start || now >= table_end) {
+        clock_build_transitions(now);
+    }
+    localtime_r(&now, &cached);
+    cached_time = now;
+    engine_stats.full_conversions++;
+
+    // 本地时间的下一个零点和下一个切换时刻, 取较早者
+    time_t seconds_of_day = cached.tm_hour * 3600 + cached.tm_min * 60 + cached.tm_sec;
+    valid_until = now + (SECONDS_PER_DAY - seconds_of_day);
+    for (int i = 0; i < transition_count; i++) {
+        if (transitions[i] > now) {
+            if (transitions[i] < valid_until) {
+                valid_until = transitions[i];
+            }
+            break;
+        }
+    }
+    if (valid_until > table_end) {
+        valid_until = table_end;
+    }
+}
+
+esp_err_t clock_engine_init(const char *tz) {
+    ESP_RETURN_ON_FALSE(tz, ESP_ERR_INVALID_ARG, TAG, "invalid timezone");
+    setenv("TZ", tz, 1);
+    tzset();
+    clock_build_transitions(time(NULL));
+    cache_invalid = true;
+    ESP_LOGI(TAG, "Timezone %s, %d transitions precomputed", tz, transition_count);
+    return ESP_OK;
+}
+
+void clock_engine_localtime(time_t now, struct tm *timeinfo) {
+    if (cache_invalid || now < cached_time || now >= valid_until) {
+        clock_full_conversion(now);
+    } else if (now != cached_time) {
+        engine_stats.incremental++;
+        if (now == cached_time + 1) {
+            // 每秒刷新的常见情况, 只需要进位
+            if (++cached.tm_sec == 60) {
+                cached.tm_sec = 0;
+                if (++cached.tm_min == 60) {
+                    cached.tm_min = 0;
+                    cached.tm_hour++;
+                }
+            }
+        } else {
+            // 同一天内跳过了若干秒
+            time_t seconds_of_day = cached.tm_hour * 3600 + cached.tm_min * 60 + cached.tm_sec + (now - cached_time);
+            cached.tm_hour = seconds_of_day / 3600;
+            cached.tm_min = (seconds_of_day / 60) % 60;
+            cached.tm_sec = seconds_of_day % 60;
+        }
+        cached_time = now;
+    }
+    *timeinfo = cached;
+}
+
+void clock_engine_invalidate(void) {
+    cache_invalid = true;
+}
+
+int clock_engine_get_transitions(const time_t **list) {
+    *list = transitions;
+    return transition_count;
+}
+
+void clock_engine_get_stats(clock_engine_stats_t *stats) {
+    *stats = engine_stats;
+}
@@ -0,0 +1,38 @@
+#ifndef CLOCK_ENGINE_H
+#define CLOCK_ENGINE_H
+
+#include <stdint.h>
+#include <time.h>
+#include "esp_err.h"
+
+// 预先计算的时区规则切换时刻 (夏令时开始/结束) 的最大数量
+#define CLOCK_ENGINE_MAX_TRANSITIONS 16
+
+// 预先计算切换时刻的时间跨度
+#define CLOCK_ENGINE_TRANSITION_YEARS 4
+
+/**
+ * @brief Clock engine statistics
+ */
+typedef struct {
+    uint32_t full_conversions;  /*!< Calls that ran localtime_r */
+    uint32_t incremental;       /*!< Calls answered by advancing the cached broken-down time */
+    uint32_t transitions;       /*!< Entries in the precomputed transition table */
+} clock_engine_stats_t;
+
+// 设置时区 (POSIX TZ 格式) 并预先计算之后几年内的时区规则切换时刻
+esp_err_t clock_engine_init(const char *tz);
+
+// 与 localtime_r 结果相同, 同一天内且没有跨越切换时刻时只做整数递增
+// 跨天、跨越切换时刻、时间回退或调用 clock_engine_invalidate 之后重新完整换算
+void clock_engine_localtime(time_t now, struct tm *timeinfo);
+
+// 系统时间被校准后调用, 下一次换算时重新完整换算, 可以在任意任务中调用
+void clock_engine_invalidate(void);
+
+// 返回预先计算的切换时刻表 (UTC 秒数, 升序) 及其长度
+int clock_engine_get_transitions(const time_t **transitions);
+
+void clock_engine_get_stats(clock_engine_stats_t *stats);
+
+#endif // CLOCK_ENGINE_H
@@ -0,0 +1,53 @@
+#include <math.h>
+#include <stdlib.h>
+#include "sdkconfig.h"
+#include "clock_servo.h"
+
+float clock_servo_next_ppm(float ppm, int64_t residual_us, int64_t elapsed_us)
+{
+    if (elapsed_us <= 0) {
+        return ppm;
+    }
+    // 按比例修正, 避免单个带噪声的样本使估计来回摆动
+    float residual_ppm = (float)residual_us * 1e6f / (float)elapsed_us;
+    ppm += residual_ppm * CONFIG_CLOCK_DISCIPLINE_GAIN_PERCENT / 100.0f;
+    if (ppm > CONFIG_CLOCK_DISCIPLINE_MAX_PPM) {
+        ppm = CONFIG_CLOCK_DISCIPLINE_MAX_PPM;
+    } else if (ppm < -CONFIG_CLOCK_DISCIPLINE_MAX_PPM) {
+        ppm = -CONFIG_CLOCK_DISCIPLINE_MAX_PPM;
+    }
+    return ppm;
+}
+
+bool clock_servo_next_interval(clock_servo_interval_t *servo, int64_t drift_us, int64_t elapsed_us)
+{
+    bool exceeded = false;
+    uint32_t interval_s = servo->interval_s ? servo->interval_s : CONFIG_SNTP_MIN_INTERVAL_S;
+    servo->syncs++;
+    if (servo->syncs == 1 || elapsed_us <= 0) {
+        interval_s = CONFIG_SNTP_MIN_INTERVAL_S;
+    } else {
+        float sample_ppm = (float)drift_us * 1e6f / (float)elapsed_us;
+        servo->drift_ppm = servo->drift_samples == 0 ? sample_ppm : servo->drift_ppm + (sample_ppm - servo->drift_ppm) / 4;
+        servo->drift_samples++;
+
+        if (llabs(drift_us / 1000) > CONFIG_SNTP_ERROR_BUDGET_MS) {
+            // 超出误差预算, 间隔减半
+            exceeded = true;
+            interval_s /= 2;
+        } else {
+            float limit_s = CONFIG_SNTP_MAX_INTERVAL_S;
+            if (fabsf(servo->drift_ppm) > 0.01f) {
+                limit_s = (CONFIG_SNTP_ERROR_BUDGET_MS / 2000.0f) / (fabsf(servo->drift_ppm) * 1e-6f);
+            }
+            interval_s = interval_s * 2 < limit_s ? interval_s * 2 : (uint32_t)limit_s;
+        }
+    }
+    if (interval_s < CONFIG_SNTP_MIN_INTERVAL_S) {
+        interval_s = CONFIG_SNTP_MIN_INTERVAL_S;
+    } else if (interval_s > CONFIG_SNTP_MAX_INTERVAL_S) {
+        interval_s = CONFIG_SNTP_MAX_INTERVAL_S;
+    }
+    servo->interval_s = interval_s;
+    return exceeded;
+}
@@ -0,0 +1,28 @@
+#ifndef CLOCK_SERVO_H
+#define CLOCK_SERVO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 对时的控制计算, 不依赖系统时钟和网络, 主机测试可以直接驱动
+
+/**
+ * @brief Sync interval state
+ */
+typedef struct {
+    uint32_t syncs;             /*!< Syncs fed to clock_servo_next_interval */
+    uint32_t drift_samples;     /*!< Samples averaged into drift_ppm */
+    float drift_ppm;            /*!< Smoothed drift left after the discipline, positive when the local clock runs slow */
+    uint32_t interval_s;        /*!< Interval chosen for the next sync */
+} clock_servo_interval_t;
+
+// 剩余误差对应的频率偏差按 CONFIG_CLOCK_DISCIPLINE_GAIN_PERCENT 计入估计, 返回新的估计
+// residual_us 为这段时间内累积的误差, elapsed_us 为这段时间的长度
+float clock_servo_next_ppm(float ppm, int64_t residual_us, int64_t elapsed_us);
+
+// 根据一次对时的剩余误差更新漂移估计, 选出下一次对时的间隔
+// 误差按当前漂移累积到预算的一半时再对时, 第一次对时只是把时间设准, 误差被忽略
+// 返回 true 表示误差超出了 CONFIG_SNTP_ERROR_BUDGET_MS
+bool clock_servo_next_interval(clock_servo_interval_t *servo, int64_t drift_us, int64_t elapsed_us);
+
+#endif // CLOCK_SERVO_H
@@ -0,0 +1,29 @@
+#include <stddef.h>
+#include "font.h"
+#include "font_atlas_data.h"
+
+const font_glyph_t *font_find_glyph(uint32_t codepoint) {
+    if (codepoint < 128) {
+        int16_t index = font_atlas_ascii[codepoint];
+        return index < 0 ? NULL : &font_atlas_glyphs[index];
+    }
+    // 非 ASCII 字模按码位二分查找
+    int low = 0;
+    int high = FONT_ATLAS_GLYPH_COUNT - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        if (font_atlas_glyphs[mid].codepoint == codepoint) {
+            return &font_atlas_glyphs[mid];
+        }
+        if (font_atlas_glyphs[mid].codepoint < codepoint) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return NULL;
+}
+
+const uint8_t *font_glyph_columns(const font_glyph_t *glyph) {
+    return &font_atlas_columns[glyph->offset];
+}
@@ -0,0 +1,21 @@
+#ifndef FONT_H
+#define FONT_H
+
+#include <stdint.h>
+
+/**
+ * @brief Glyph in the font atlas generated from fonts.xlsx by tools/font_atlas.py
+ */
+typedef struct {
+    uint32_t codepoint; /*!< Unicode code point */
+    uint16_t offset;    /*!< First column of the glyph in the atlas */
+    uint8_t width;      /*!< Number of columns, one byte each, MSB on the top row */
+    uint8_t spacing;    /*!< Blank columns drawn after the glyph */
+} font_glyph_t;
+
+// 查找字模, 不存在时返回 NULL
+const font_glyph_t *font_find_glyph(uint32_t codepoint);
+
+const uint8_t *font_glyph_columns(const font_glyph_t *glyph);
+
+#endif // FONT_H
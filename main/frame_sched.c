@@ -0,0 +1,108 @@
+#include <stdlib.h>
+#include <sys/time.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "frame_sched.h"
+
+static const char *TAG = "frame_sched";
+
+static esp_timer_handle_t frame_timer;
+static TaskHandle_t frame_task;
+static volatile uint32_t frame_fps;         // 0 表示整秒触发
+static int64_t frame_period_us;
+static int64_t next_target_us;              // 动画模式下一帧的预期时间 (esp_timer 时基)
+static volatile int64_t notify_time_us;     // 最近一次通知显示任务的时间
+
+static frame_sched_stats_t sched_stats;
+static uint64_t jitter_sum_us;
+
+static void frame_sched_record_jitter(int32_t jitter_us) {
+    sched_stats.last_jitter_us = jitter_us;
+    if (jitter_us > sched_stats.max_jitter_us) {
+        sched_stats.max_jitter_us = jitter_us;
+    }
+    jitter_sum_us += abs(jitter_us);
+    sched_stats.avg_jitter_us = jitter_sum_us / (sched_stats.frames + 1);
+}
+
+static void frame_sched_timer_cb(void *arg) {
+    sched_stats.wakeups++;
+    if (frame_fps == 0) {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        // esp_timer 与系统时间之间有微小偏差, 对时也会让系统时间跳变
+        // 提前触发时补足到整秒的剩余时间, 本次不出帧
+        if (tv.tv_usec >= 500000) {
+            sched_stats.early++;
+            esp_timer_start_once(frame_timer, 1000000 - tv.tv_usec);
+            return;
+        }
+        frame_sched_record_jitter(tv.tv_usec);
+        // 每次都按系统时间重新对齐到下一个整秒
+        esp_timer_start_once(frame_timer, 1000000 - tv.tv_usec);
+    } else {
+        int64_t now = esp_timer_get_time();
+        frame_sched_record_jitter(now - next_target_us);
+        next_target_us += frame_period_us;
+    }
+    sched_stats.frames++;
+    notify_time_us = esp_timer_get_time();
+    xTaskNotifyGive(frame_task);
+}
+
+// 停止定时器后按当前模式重新启动, 回调可能在两步之间重新装载定时器, 失败时重试
+static esp_err_t frame_sched_arm(void) {
+    esp_err_t err;
+    do {
+        esp_timer_stop(frame_timer);
+        if (frame_fps == 0) {
+            struct timeval tv;
+            gettimeofday(&tv, NULL);
+            err = esp_timer_start_once(frame_timer, 1000000 - tv.tv_usec);
+        } else {
+            frame_period_us = 1000000 / frame_fps;
+            next_target_us = esp_timer_get_time() + frame_period_us;
+            err = esp_timer_start_periodic(frame_timer, frame_period_us);
+        }
+    } while (err == ESP_ERR_INVALID_STATE);
+    return err;
+}
+
+esp_err_t frame_sched_start(TaskHandle_t task) {
+    ESP_RETURN_ON_FALSE(task, ESP_ERR_INVALID_ARG, TAG, "invalid task");
+    ESP_RETURN_ON_FALSE(frame_timer == NULL, ESP_ERR_INVALID_STATE, TAG, "already started");
+    frame_task = task;
+    const esp_timer_create_args_t timer_args = {
+        .callback = frame_sched_timer_cb,
+        .name = "frame_sched",
+    };
+    ESP_RETURN_ON_ERROR(esp_timer_create(&timer_args, &frame_timer), TAG, "create timer failed");
+    return frame_sched_arm();
+}
+
+esp_err_t frame_sched_set_fps(uint32_t fps) {
+    ESP_RETURN_ON_FALSE(frame_timer, ESP_ERR_INVALID_STATE, TAG, "not started");
+    ESP_RETURN_ON_FALSE(fps <= 1000, ESP_ERR_INVALID_ARG, TAG, "fps too high");
+    if (fps == frame_fps) {
+        return ESP_OK;
+    }
+    frame_fps = fps;
+    return frame_sched_arm();
+}
+
+BaseType_t frame_sched_wait(TickType_t timeout) {
+    if (ulTaskNotifyTake(pdTRUE, timeout) == 0) {
+        return pdFALSE;
+    }
+    uint32_t latency = esp_timer_get_time() - notify_time_us;
+    sched_stats.last_latency_us = latency;
+    if (latency > sched_stats.max_latency_us) {
+        sched_stats.max_latency_us = latency;
+    }
+    return pdTRUE;
+}
+
+void frame_sched_get_stats(frame_sched_stats_t *stats) {
+    *stats = sched_stats;
+}
@@ -0,0 +1,35 @@
+#ifndef FRAME_SCHED_H
+#define FRAME_SCHED_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/**
+ * @brief Frame scheduler statistics
+ */
+typedef struct {
+    uint32_t wakeups;           /*!< Timer callbacks since the scheduler started */
+    uint32_t frames;            /*!< Frames signalled to the display task */
+    uint32_t early;             /*!< Callbacks that fired before the second boundary and were re-armed without a frame */
+    int32_t last_jitter_us;     /*!< Lateness of the last frame relative to its target instant, in microseconds */
+    int32_t max_jitter_us;      /*!< Largest lateness seen, in microseconds */
+    uint32_t avg_jitter_us;     /*!< Mean absolute lateness, in microseconds */
+    uint32_t last_latency_us;   /*!< Time from the timer callback to the display task waking up, for the last frame */
+    uint32_t max_latency_us;    /*!< Largest wake-up latency seen */
+} frame_sched_stats_t;
+
+// 启动帧调度, 每到一帧通过任务通知唤醒 task
+// 默认在系统时间的每个整秒触发, 每次都按当前系统时间重新对齐, 对时后自动跟上
+esp_err_t frame_sched_start(TaskHandle_t task);
+
+// 设置动画帧率, 0 表示回到整秒触发
+esp_err_t frame_sched_set_fps(uint32_t fps);
+
+// 在显示任务中等待下一帧, 返回 pdTRUE 表示到了新的一帧
+BaseType_t frame_sched_wait(TickType_t timeout);
+
+void frame_sched_get_stats(frame_sched_stats_t *stats);
+
+#endif // FRAME_SCHED_H
@@ -0,0 +1,88 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "unity.h"
+#include "sdkconfig.h"
+#include "clock_servo.h"
+
+#define SERVO_SIM_DAYS 30
+// 模拟的 NTP 应答误差上限, 相当于 Wi-Fi 上不对称的往返延迟
+#define SERVO_SIM_JITTER_US 5000
+// 定时微调的周期很短, 模拟中把补偿当作连续的
+#define SERVO_SIM_STEP_S 1
+
+typedef struct {
+    int64_t now_us;             /*!< 真实时间 */
+    double error_us;            /*!< 本地时钟减去真实时间 */
+    uint32_t seed;
+    uint32_t queries;           /*!< 向模拟服务器发出的请求 */
+} servo_sim_t;
+
+// 模拟的 NTP 服务器: 返回本地时钟的偏差, 带均匀分布的测量误差
+static int64_t servo_sim_query(servo_sim_t *sim)
+{
+    sim->seed = sim->seed * 1103515245 + 12345;
+    int32_t jitter = (int32_t)((sim->seed >> 8) % (2 * SERVO_SIM_JITTER_US + 1)) - SERVO_SIM_JITTER_US;
+    sim->queries++;
+    return (int64_t)(-sim->error_us) + jitter;
+}
+
+typedef struct {
+    uint32_t queries;
+    double max_error_ms;        /*!< 第一次对时之后本地时钟的最大误差 */
+    float ppm;
+    uint32_t interval_s;
+} servo_sim_result_t;
+
+// 晶振频率误差为 crystal_ppm (正值表示走慢) 的时钟运行 SERVO_SIM_DAYS 天
+// 每次对时平滑校准全部偏差, 校准估计在两次对时之间持续补偿漂移
+static void servo_sim_run(float crystal_ppm, servo_sim_result_t *result)
+{
+    servo_sim_t sim = { .error_us = 3e6, .seed = 1 };
+    clock_servo_interval_t servo = { 0 };
+    float ppm = 0;
+    int64_t last_sync_us = 0;
+    int64_t next_sync_us = 0;
+    result->max_error_ms = 0;
+    while (sim.now_us < SERVO_SIM_DAYS * 86400LL * 1000000) {
+        if (sim.now_us >= next_sync_us) {
+            int64_t offset_us = servo_sim_query(&sim);
+            if (servo.syncs > 0) {
+                ppm = clock_servo_next_ppm(ppm, offset_us, sim.now_us - last_sync_us);
+            }
+            clock_servo_next_interval(&servo, offset_us, sim.now_us - last_sync_us);
+            sim.error_us += offset_us;
+            last_sync_us = sim.now_us;
+            next_sync_us = sim.now_us + servo.interval_s * 1000000LL;
+        }
+        sim.now_us += SERVO_SIM_STEP_S * 1000000LL;
+        sim.error_us += (ppm - crystal_ppm) * SERVO_SIM_STEP_S;
+        if (servo.syncs > 0 && fabs(sim.error_us) / 1000 > result->max_error_ms) {
+            result->max_error_ms = fabs(sim.error_us) / 1000;
+        }
+    }
+    result->queries = sim.queries;
+    result->ppm = ppm;
+    result->interval_s = servo.interval_s;
+}
+
+TEST_CASE("drifting clock stays within the error budget with few queries", "[clock_servo]")
+{
+    static const float crystal_ppm[] = {0, 20, -42, 150};
+    // 按最短间隔定时对时所需的请求数
+    const uint32_t fixed_queries = SERVO_SIM_DAYS * 86400 / CONFIG_SNTP_MIN_INTERVAL_S;
+    for (size_t i = 0; i < sizeof(crystal_ppm) / sizeof(crystal_ppm[0]); i++) {
+        servo_sim_result_t result;
+        servo_sim_run(crystal_ppm[i], &result);
+        printf("crystal %+.0f ppm: %" PRIu32 " queries in %d days (fixed interval: %" PRIu32 "), "
+               "max error %.1f ms, estimate %+.2f ppm, interval %" PRIu32 " s\n",
+               crystal_ppm[i], result.queries, SERVO_SIM_DAYS, fixed_queries,
+               result.max_error_ms, result.ppm, result.interval_s);
+        TEST_ASSERT_LESS_OR_EQUAL_DOUBLE(CONFIG_SNTP_ERROR_BUDGET_MS, result.max_error_ms);
+        TEST_ASSERT_FLOAT_WITHIN(1.0f, crystal_ppm[i], result.ppm);
+        // 估计收敛之后间隔应达到上限, 请求数是最短间隔的零头
+        TEST_ASSERT_EQUAL_UINT32(CONFIG_SNTP_MAX_INTERVAL_S, result.interval_s);
+        TEST_ASSERT_LESS_OR_EQUAL(fixed_queries / 100, result.queries);
+    }
+}
@@ -0,0 +1,212 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "dsp_kernels.h"
+#include "host_test.h"
+
+#define DSP_TEST_MAX_FFT 1024
+// Q15 FFT 与双精度 DFT / N 之间允许的误差
+#define DSP_TEST_FFT_LSB 4
+// 负载基准: 1 秒 48 kHz 立体声, 按 I2S 每块 60 帧送入
+#define DSP_BENCH_RATE 48000
+#define DSP_BENCH_BLOCK 60
+#define DSP_BENCH_RUNS 5
+
+static dsp_cq15_t fft_data[DSP_TEST_MAX_FFT];
+static dsp_cq15_t fft_input[DSP_TEST_MAX_FFT];
+
+static int16_t dsp_test_random_q15(void)
+{
+    return (int16_t)(rand() % 65535 - 32767);
+}
+
+// 直接按定义计算的 DFT, 除以 n, 返回输出各分量与 FFT 结果的最大误差
+static double dsp_test_dft_error(const dsp_cq15_t *in, const dsp_cq15_t *out, uint32_t n)
+{
+    double max_error = 0;
+    for (uint32_t k = 0; k < n; k++) {
+        double re = 0, im = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            double angle = -2.0 * M_PI * (double)((uint64_t)i * k % n) / n;
+            re += in[i].re * cos(angle) - in[i].im * sin(angle);
+            im += in[i].re * sin(angle) + in[i].im * cos(angle);
+        }
+        max_error = fmax(max_error, fabs(re / n - out[k].re));
+        max_error = fmax(max_error, fabs(im / n - out[k].im));
+    }
+    return max_error;
+}
+
+static void dsp_test_fft(uint32_t n, bool complex_input)
+{
+    dsp_fft_plan_t plan;
+    TEST_ASSERT_EQUAL(ESP_OK, dsp_fft_plan_init(&plan, n));
+    for (uint32_t i = 0; i < n; i++) {
+        if (complex_input) {
+            // 复数输入的模不能超过 32767
+            double radius = 32767.0 * rand() / RAND_MAX;
+            double angle = 2.0 * M_PI * rand() / RAND_MAX;
+            fft_input[i].re = (int16_t)(radius * cos(angle));
+            fft_input[i].im = (int16_t)(radius * sin(angle));
+        } else {
+            fft_input[i].re = dsp_test_random_q15();
+            fft_input[i].im = 0;
+        }
+        fft_data[i] = fft_input[i];
+    }
+    dsp_fft_r4_q15(&plan, fft_data);
+    double error = dsp_test_dft_error(fft_input, fft_data, n);
+    printf("fft %4lu points, %s input: max error %.2f LSB\n", (unsigned long)n, complex_input ? "complex" : "real", error);
+    dsp_fft_plan_free(&plan);
+    TEST_ASSERT_LESS_OR_EQUAL_DOUBLE(DSP_TEST_FFT_LSB, error);
+}
+
+TEST_CASE("fft matches a double precision DFT within 4 LSB", "[dsp_kernels]")
+{
+    srand(1);
+    for (uint32_t n = 16; n <= DSP_TEST_MAX_FFT; n *= 4) {
+        dsp_test_fft(n, false);
+        dsp_test_fft(n, true);
+    }
+    // 满幅直流和奈奎斯特频率的正弦
+    dsp_fft_plan_t plan;
+    TEST_ASSERT_EQUAL(ESP_OK, dsp_fft_plan_init(&plan, 256));
+    for (int i = 0; i < 256; i++) {
+        fft_input[i] = (dsp_cq15_t) { .re = 32767, .im = 0 };
+        fft_input[i + 256] = (dsp_cq15_t) { .re = i % 2 ? -32767 : 32767, .im = 0 };
+    }
+    for (int s = 0; s < 2; s++) {
+        memcpy(fft_data, fft_input + s * 256, 256 * sizeof(dsp_cq15_t));
+        dsp_fft_r4_q15(&plan, fft_data);
+        TEST_ASSERT_LESS_OR_EQUAL_DOUBLE(DSP_TEST_FFT_LSB, dsp_test_dft_error(fft_input + s * 256, fft_data, 256));
+    }
+    dsp_fft_plan_free(&plan);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, dsp_fft_plan_init(&plan, 128));
+}
+
+TEST_CASE("element-wise kernels match their reference", "[dsp_kernels]")
+{
+    enum { N = 1000 };     // 不是 16 的倍数, 覆盖尾部
+    static int16_t in[N], window[N], out[N];
+    static dsp_cq15_t cin[N];
+    static uint32_t mag[N];
+    static uint8_t u8_in[N], u8_out[N], u8_dst[N];
+    srand(2);
+    for (int i = 0; i < N; i++) {
+        in[i] = dsp_test_random_q15();
+        window[i] = rand() % 32768;
+        cin[i] = (dsp_cq15_t) { .re = dsp_test_random_q15(), .im = dsp_test_random_q15() };
+        u8_in[i] = rand();
+        u8_dst[i] = rand();
+    }
+    // in 与 out 相同时也要成立
+    dsp_window_q15(out, in, window, N);
+    for (int i = 0; i < N; i++) {
+        TEST_ASSERT_EQUAL_INT16((int16_t)floor(in[i] * (double)window[i] / 32768.0), out[i]);
+    }
+    memcpy(out, in, sizeof(out));
+    dsp_window_q15(out, out, window, N);
+    for (int i = 0; i < N; i++) {
+        TEST_ASSERT_EQUAL_INT16((int16_t)floor(in[i] * (double)window[i] / 32768.0), out[i]);
+    }
+
+    dsp_magnitude_sq_q15(mag, cin, N);
+    for (int i = 0; i < N; i++) {
+        TEST_ASSERT_EQUAL_UINT32((int64_t)cin[i].re * cin[i].re + (int64_t)cin[i].im * cin[i].im, mag[i]);
+    }
+    // 最大的平方和 2 * 32768² 刚好放得下
+    dsp_cq15_t corner = { .re = -32768, .im = -32768 };
+    dsp_magnitude_sq_q15(mag, &corner, 1);
+    TEST_ASSERT_EQUAL_UINT32(2147483648u, mag[0]);
+
+    for (int scale = 0; scale < 256; scale += 51) {
+        dsp_u8_scale(u8_out, u8_in, scale, N);
+        for (int i = 0; i < N; i++) {
+            TEST_ASSERT_EQUAL(u8_in[i] * scale / 256, u8_out[i]);
+        }
+    }
+    memcpy(u8_out, u8_dst, sizeof(u8_out));
+    dsp_u8_blend_add(u8_out, u8_in, 200, N);
+    for (int i = 0; i < N; i++) {
+        int expected = u8_dst[i] + u8_in[i] * 200 / 256;
+        TEST_ASSERT_EQUAL(expected > 255 ? 255 : expected, u8_out[i]);
+    }
+}
+
+TEST_CASE("band bank measures a sine in its pass band", "[dsp_kernels]")
+{
+    enum { RATE = 48000, FRAMES = RATE / 4 };
+    static int16_t stereo[FRAMES * 2];
+    const dsp_band_spec_t specs[] = { { 40, 250 }, { 250, 2500 }, { 2500, 16000 } };
+    static const float tone_hz[] = { 100, 1000, 6000 };
+    dsp_band_bank_t bank;
+    TEST_ASSERT_EQUAL(ESP_OK, dsp_band_bank_init(&bank, RATE, specs, 3));
+    for (int t = 0; t < 3; t++) {
+        for (int i = 0; i < FRAMES; i++) {
+            stereo[2 * i] = stereo[2 * i + 1] = lround(32767 * sin(2 * M_PI * tone_hz[t] * i / RATE));
+        }
+        // 第一块让滤波器进入稳态, 只测第二块
+        float mean_square[3];
+        dsp_band_bank_process(&bank, stereo, FRAMES, 2, 16);
+        dsp_band_bank_read(&bank, mean_square);
+        dsp_band_bank_process(&bank, stereo, FRAMES, 2, 16);
+        TEST_ASSERT_EQUAL(FRAMES, dsp_band_bank_read(&bank, mean_square));
+        printf("%5.0f Hz: %.3f %.3f %.3f\n", tone_hz[t], mean_square[0], mean_square[1], mean_square[2]);
+        for (int b = 0; b < 3; b++) {
+            if (b == t) {
+                TEST_ASSERT_FLOAT_WITHIN(0.05f, 0.5f, mean_square[b]);
+            } else {
+                TEST_ASSERT_LESS_THAN_FLOAT(0.05f, mean_square[b]);
+            }
+        }
+    }
+    float mean_square[3];
+    TEST_ASSERT_EQUAL(0, dsp_band_bank_read(&bank, mean_square));
+
+    // 分块累加的结果与整块处理后读出的相同, 且不改变 bank 自己的累加
+    dsp_band_bank_t copy = bank;
+    float energy[3] = { 0 };
+    for (int i = 0; i < FRAMES; i += 100) {
+        dsp_band_bank_accumulate(&copy, stereo + 2 * i, 100, 2, 16, energy);
+    }
+    dsp_band_bank_process(&bank, stereo, FRAMES, 2, 16);
+    dsp_band_bank_read(&bank, mean_square);
+    for (int b = 0; b < 3; b++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f * mean_square[b] + 1e-9f, mean_square[b], energy[b] / FRAMES);
+    }
+    TEST_ASSERT_EQUAL(0, dsp_band_bank_read(&copy, mean_square));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, dsp_band_bank_init(&bank, RATE, (dsp_band_spec_t[]) { { 1000, 30000 } }, 1));
+}
+
+TEST_CASE("ambient band bank load at 48 kHz", "[dsp_kernels][bench]")
+{
+    static int16_t stereo[DSP_BENCH_RATE * 2];
+    const dsp_band_spec_t specs[] = { { 40, 250 }, { 250, 4000 }, { 4000, 16000 } };
+    dsp_band_bank_t bank;
+    TEST_ASSERT_EQUAL(ESP_OK, dsp_band_bank_init(&bank, DSP_BENCH_RATE, specs, 3));
+    srand(3);
+    for (int i = 0; i < DSP_BENCH_RATE * 2; i++) {
+        stereo[i] = dsp_test_random_q15() / 4;
+    }
+    // 与 spectrum_feed 相同的调用方式, 多次运行取最快的一次
+    int64_t best = INT64_MAX;
+    float energy[3] = { 0 };
+    for (int run = 0; run < DSP_BENCH_RUNS; run++) {
+        int64_t start = host_test_now_ns();
+        for (int i = 0; i < DSP_BENCH_RATE; i += DSP_BENCH_BLOCK) {
+            dsp_band_bank_accumulate(&bank, stereo + 2 * i, DSP_BENCH_BLOCK, 2, 16, energy);
+        }
+        int64_t cost = host_test_now_ns() - start;
+        if (cost < best) {
+            best = cost;
+        }
+    }
+    printf("band bank 3 bands: %.2f us per %d-frame block, %.3f%% of one host core at %d Hz\n",
+           best / 1e3 / (DSP_BENCH_RATE / DSP_BENCH_BLOCK), DSP_BENCH_BLOCK, best / 1e7, DSP_BENCH_RATE);
+    TEST_ASSERT_GREATER_THAN_FLOAT(0.0f, energy[0]);
+    // 主机比 ESP32-S3 快得多, 这里只防止数量级的退化: 1 秒音频的处理时间不超过 1% 即 10 ms.
+    // 设备上的负载由 DSP_KERNELS_BENCHMARK 测量
+    TEST_ASSERT_LESS_THAN_INT64(10000000, best);
+}
@@ -0,0 +1,89 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "host_test.h"
+#include "led_strip_spi_encoder.h"
+
+#define SPI_BENCH_RUNS 50
+#define SPI_CHECK_LEDS 64
+#define SPI_BYTES_PER_PIXEL (SPI_BYTES_PER_COLOR_BYTE * 3)
+
+// 查表之前的编码方式: 先清零像素的 9 个字节, 再逐位展开 G, R, B
+static void spi_encode_pixels_bitwise(uint8_t *buf, const uint8_t *rgb, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++, buf += SPI_BYTES_PER_PIXEL, rgb += 3) {
+        memset(buf, 0, SPI_BYTES_PER_PIXEL);
+        led_strip_spi_encode_bit(rgb[1], buf);
+        led_strip_spi_encode_bit(rgb[0], buf + SPI_BYTES_PER_COLOR_BYTE);
+        led_strip_spi_encode_bit(rgb[2], buf + SPI_BYTES_PER_COLOR_BYTE * 2);
+    }
+}
+
+static void spi_random_frame(uint8_t *rgb, uint32_t leds)
+{
+    for (uint32_t i = 0; i < leds * 3; i++) {
+        rgb[i] = rand();
+    }
+}
+
+TEST_CASE("spi pattern table matches the per-bit encoding", "[led_strip]")
+{
+    led_strip_spi_encoder_init();
+    for (int value = 0; value < 256; value++) {
+        uint8_t expected[SPI_BYTES_PER_COLOR_BYTE] = {0};
+        led_strip_spi_encode_bit(value, expected);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, led_strip_spi_lut[value], SPI_BYTES_PER_COLOR_BYTE);
+    }
+
+    uint8_t rgb[SPI_CHECK_LEDS * 3];
+    uint8_t expected[SPI_CHECK_LEDS * SPI_BYTES_PER_PIXEL];
+    uint8_t actual[SPI_CHECK_LEDS * SPI_BYTES_PER_PIXEL];
+    spi_random_frame(rgb, SPI_CHECK_LEDS);
+    spi_encode_pixels_bitwise(expected, rgb, SPI_CHECK_LEDS);
+    led_strip_spi_encode_pixels(actual, rgb, SPI_CHECK_LEDS, false);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, actual, sizeof(actual));
+}
+
+// 多次运行取最快的一次, 排除调度和缓存冷启动
+static int64_t spi_bench_ns(bool table, uint8_t *buf, const uint8_t *rgb, uint32_t leds)
+{
+    int64_t best = INT64_MAX;
+    for (int run = 0; run < SPI_BENCH_RUNS; run++) {
+        int64_t start = host_test_now_ns();
+        if (table) {
+            led_strip_spi_encode_pixels(buf, rgb, leds, false);
+        } else {
+            spi_encode_pixels_bitwise(buf, rgb, leds);
+        }
+        int64_t cost = host_test_now_ns() - start;
+        if (cost < best) {
+            best = cost;
+        }
+    }
+    return best;
+}
+
+TEST_CASE("spi pattern table is 4x faster than the per-bit loop", "[led_strip][bench]")
+{
+    static const uint32_t sizes[] = {256, 1024};
+    led_strip_spi_encoder_init();
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        const uint32_t leds = sizes[i];
+        uint8_t *rgb = malloc(leds * 3);
+        uint8_t *buf = malloc(leds * SPI_BYTES_PER_PIXEL);
+        TEST_ASSERT_NOT_NULL(rgb);
+        TEST_ASSERT_NOT_NULL(buf);
+        spi_random_frame(rgb, leds);
+
+        int64_t bitwise_ns = spi_bench_ns(false, buf, rgb, leds);
+        int64_t table_ns = spi_bench_ns(true, buf, rgb, leds);
+        double speedup = (double)bitwise_ns / table_ns;
+        printf("spi encode %4" PRIu32 " LEDs: per-bit %.1f Mpixel/s, table %.1f Mpixel/s, %.1fx\n",
+               leds, leds * 1e3 / bitwise_ns, leds * 1e3 / table_ns, speedup);
+        free(rgb);
+        free(buf);
+        TEST_ASSERT_GREATER_OR_EQUAL_DOUBLE(4.0, speedup);
+    }
+}
@@ -0,0 +1,16 @@
+#include <stdlib.h>
+#include "sdkconfig.h"
+#include "unity.h"
+
+// 主机测试入口: 运行全部用例, 退出码为失败的用例数
+void app_main(void)
+{
+    UNITY_BEGIN();
+#if CONFIG_HOST_TESTS_BENCH
+    unity_run_all_tests();
+#else
+    // 计时结果受主机负载影响, 默认只运行结果确定的用例
+    unity_run_tests_by_tag("[bench]", true);
+#endif
+    exit(UNITY_END());
+}
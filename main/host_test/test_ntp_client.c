@@ -0,0 +1,121 @@
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "unity.h"
+#include "sdkconfig.h"
+#include "host_test.h"
+#include "ntp_client.h"
+
+// 模拟服务器: 偏差 500 ms, 返回路径延迟 20 ms 和 60 ms 的两个正常服务器, 以及一个快 2 s 的错误时钟
+#define NTP_TEST_OFFSET_MS  500
+#define NTP_TEST_DELAY_MS   20
+#define NTP_TEST_SERVERS    3
+static const char *const ntp_test_specs[NTP_TEST_SERVERS] = { "0:500:20", "0:500:60", "0:2000:10" };
+
+// 启动 tools/ntp_test_server.py, 等它打印绑定的端口, 失败返回 -1
+static pid_t ntp_test_server_start(int *ports)
+{
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        const char *argv[NTP_TEST_SERVERS + 3] = { HOST_TEST_PYTHON, HOST_TEST_NTP_SERVER };
+        memcpy(&argv[2], ntp_test_specs, sizeof(ntp_test_specs));
+        execvp(argv[0], (char *const *)argv);
+        _exit(127);
+    }
+    close(fds[1]);
+    char line[128];
+    size_t len = 0;
+    while (pid > 0 && len < sizeof(line) - 1 && (len == 0 || line[len - 1] != '\n')) {
+        ssize_t n = read(fds[0], line + len, sizeof(line) - 1 - len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        len += n;
+    }
+    close(fds[0]);
+    line[len] = '\0';
+    if (pid > 0 && sscanf(line, "ready %d %d %d", &ports[0], &ports[1], &ports[2]) != NTP_TEST_SERVERS) {
+        kill(pid, SIGTERM);
+        waitpid(pid, NULL, 0);
+        return -1;
+    }
+    return pid;
+}
+
+// 本机上没有人监听的 UDP 端口, 请求会收到 ICMP 端口不可达
+static int ntp_test_closed_port(void)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t addr_len = sizeof(addr);
+    bind(sock, (struct sockaddr *)&addr, sizeof(addr));
+    getsockname(sock, (struct sockaddr *)&addr, &addr_len);
+    close(sock);
+    return ntohs(addr.sin_port);
+}
+
+TEST_CASE("ntp client measures offset and delay and rejects the falseticker", "[ntp_client]")
+{
+    int ports[NTP_TEST_SERVERS];
+    pid_t server = ntp_test_server_start(ports);
+    TEST_ASSERT_GREATER_THAN_MESSAGE(0, server, "failed to start " HOST_TEST_NTP_SERVER);
+
+    char list[128];
+    snprintf(list, sizeof(list), "127.0.0.1:%d,127.0.0.1:%d,127.0.0.1:%d,127.0.0.1:%d",
+             ports[0], ports[1], ports[2], ntp_test_closed_port());
+    int64_t offset_us = 0;
+    int64_t start_ns = host_test_now_ns();
+    esp_err_t err = ntp_client_init(list);
+    if (err == ESP_OK) {
+        err = ntp_client_poll(&offset_us);
+    }
+    int64_t elapsed_ms = (host_test_now_ns() - start_ns) / 1000000;
+    kill(server, SIGTERM);
+    waitpid(server, NULL, 0);
+    TEST_ASSERT_EQUAL(ESP_OK, err);
+
+    ntp_server_stats_t stats[NTP_CLIENT_MAX_SERVERS];
+    TEST_ASSERT_EQUAL(4, ntp_client_get_stats(stats, NTP_CLIENT_MAX_SERVERS));
+    for (int i = 0; i < 4; i++) {
+        printf("%s: %lu replies, %lu timeouts, %lu outliers, %lu selected, offset %lld us, delay %lld us\n",
+               stats[i].host, (unsigned long)stats[i].replies, (unsigned long)stats[i].timeouts,
+               (unsigned long)stats[i].outliers, (unsigned long)stats[i].selected,
+               (long long)stats[i].last.offset_us, (long long)stats[i].last.delay_us);
+    }
+    printf("poll took %lld ms\n", (long long)elapsed_ms);
+
+    // 延迟全部在返回路径上, 测得的偏差比服务器时钟少一半往返时间
+    const ntp_sample_t *best = &stats[0].last;
+    TEST_ASSERT_EQUAL(CONFIG_SNTP_BURST, stats[0].replies);
+    TEST_ASSERT_INT64_WITHIN(2000, NTP_TEST_DELAY_MS * 1000, best->delay_us);
+    TEST_ASSERT_INT64_WITHIN(1000, NTP_TEST_OFFSET_MS * 1000 - best->delay_us / 2, best->offset_us);
+    TEST_ASSERT_EQUAL(1, stats[0].selected);
+    TEST_ASSERT_EQUAL(best->offset_us, offset_us);
+    // 延迟更大的正常服务器没有被选中, 也不算错误时钟
+    TEST_ASSERT_EQUAL(CONFIG_SNTP_BURST, stats[1].replies);
+    TEST_ASSERT_EQUAL(0, stats[1].selected);
+    TEST_ASSERT_EQUAL(0, stats[1].outliers);
+    // 延迟最小但偏差远离中位数的服务器被剔除
+    TEST_ASSERT_EQUAL(CONFIG_SNTP_BURST, stats[2].replies);
+    TEST_ASSERT_EQUAL(1, stats[2].outliers);
+    TEST_ASSERT_EQUAL(0, stats[2].selected);
+    // 端口不可达的请求立即记为失败, 不会拖到超时
+    TEST_ASSERT_EQUAL(0, stats[3].replies);
+    TEST_ASSERT_EQUAL(CONFIG_SNTP_BURST, stats[3].timeouts);
+    TEST_ASSERT_LESS_THAN((CONFIG_SNTP_BURST - 1) * 2000 + CONFIG_SNTP_BURST * CONFIG_SNTP_QUERY_TIMEOUT_MS / 2, elapsed_ms);
+}
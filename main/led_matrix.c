@@ -0,0 +1,19 @@
+#include "led_matrix.h"
+
+_Static_assert(LED_STRIP_LED_NUMBERS <= LED_MATRIX_MAX_LEDS, "LED matrix is larger than the mapping table");
+_Static_assert(PIXEL_WIDTH % CONFIG_LED_MATRIX_TILES_X == 0, "PIXEL_WIDTH must be a multiple of the horizontal panel count");
+_Static_assert(PIXEL_HIGHT % CONFIG_LED_MATRIX_TILES_Y == 0, "PIXEL_HIGHT must be a multiple of the vertical panel count");
+
+// 第 n 项对应坐标 (n % PIXEL_WIDTH, n / PIXEL_WIDTH), 超出显示区域的项不会被使用
+#define LED_MATRIX_ENTRY(n) \
+    ((n) < LED_STRIP_LED_NUMBERS ? LED_MATRIX_INDEX((n) % PIXEL_WIDTH, (n) / PIXEL_WIDTH) : 0)
+
+#define LED_MATRIX_REPEAT_4(n)    LED_MATRIX_ENTRY(n), LED_MATRIX_ENTRY((n) + 1), LED_MATRIX_ENTRY((n) + 2), LED_MATRIX_ENTRY((n) + 3)
+#define LED_MATRIX_REPEAT_16(n)   LED_MATRIX_REPEAT_4(n), LED_MATRIX_REPEAT_4((n) + 4), LED_MATRIX_REPEAT_4((n) + 8), LED_MATRIX_REPEAT_4((n) + 12)
+#define LED_MATRIX_REPEAT_64(n)   LED_MATRIX_REPEAT_16(n), LED_MATRIX_REPEAT_16((n) + 16), LED_MATRIX_REPEAT_16((n) + 32), LED_MATRIX_REPEAT_16((n) + 48)
+#define LED_MATRIX_REPEAT_256(n)  LED_MATRIX_REPEAT_64(n), LED_MATRIX_REPEAT_64((n) + 64), LED_MATRIX_REPEAT_64((n) + 128), LED_MATRIX_REPEAT_64((n) + 192)
+#define LED_MATRIX_REPEAT_1024(n) LED_MATRIX_REPEAT_256(n), LED_MATRIX_REPEAT_256((n) + 256), LED_MATRIX_REPEAT_256((n) + 512), LED_MATRIX_REPEAT_256((n) + 768)
+
+const uint16_t led_matrix_map[LED_MATRIX_MAX_LEDS] = {
+    LED_MATRIX_REPEAT_1024(0)
+};
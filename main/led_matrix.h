@@ -0,0 +1,38 @@
+#ifndef LED_MATRIX_H
+#define LED_MATRIX_H
+
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "ws2812b.h"
+
+// 单块面板的尺寸, 多块面板按从左到右、从上到下的顺序串联
+#define LED_MATRIX_TILE_WIDTH  (PIXEL_WIDTH / CONFIG_LED_MATRIX_TILES_X)
+#define LED_MATRIX_TILE_HIGHT  (PIXEL_HIGHT / CONFIG_LED_MATRIX_TILES_Y)
+
+// 映射表的最大容量, 由编译期展开生成
+#define LED_MATRIX_MAX_LEDS 1024
+
+// 面板内的坐标到灯珠序号
+#if CONFIG_LED_MATRIX_LAYOUT_ROW_MAJOR
+#define LED_MATRIX_TILE_INDEX(x, y) ((y) * LED_MATRIX_TILE_WIDTH + (x))
+#elif CONFIG_LED_MATRIX_LAYOUT_ROW_SERPENTINE
+#define LED_MATRIX_TILE_INDEX(x, y) ((y) * LED_MATRIX_TILE_WIDTH + (((y) & 1) ? (LED_MATRIX_TILE_WIDTH - 1 - (x)) : (x)))
+#elif CONFIG_LED_MATRIX_LAYOUT_COLUMN_MAJOR
+#define LED_MATRIX_TILE_INDEX(x, y) ((x) * LED_MATRIX_TILE_HIGHT + (y))
+#else
+#define LED_MATRIX_TILE_INDEX(x, y) ((x) * LED_MATRIX_TILE_HIGHT + (((x) & 1) ? (LED_MATRIX_TILE_HIGHT - 1 - (y)) : (y)))
+#endif
+
+// 整个显示区域的坐标到灯带序号, 参数为常量时编译器直接求值
+#define LED_MATRIX_INDEX(x, y) \
+    (((((y) / LED_MATRIX_TILE_HIGHT) * CONFIG_LED_MATRIX_TILES_X + ((x) / LED_MATRIX_TILE_WIDTH)) * (LED_MATRIX_TILE_WIDTH * LED_MATRIX_TILE_HIGHT)) \
+     + LED_MATRIX_TILE_INDEX((x) % LED_MATRIX_TILE_WIDTH, (y) % LED_MATRIX_TILE_HIGHT))
+
+// 按行优先排列的 (x, y) 到灯带序号的映射表, 下标为 y * PIXEL_WIDTH + x
+extern const uint16_t led_matrix_map[LED_MATRIX_MAX_LEDS];
+
+static inline uint16_t led_matrix_index(int x, int y) {
+    return led_matrix_map[y * PIXEL_WIDTH + x];
+}
+
+#endif // LED_MATRIX_H
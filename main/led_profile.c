@@ -0,0 +1,110 @@
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "led_profile.h"
+
+#if CONFIG_LED_PROFILE
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_timer.h"
+#endif
+
+static const char *TAG = "led_profile";
+
+static const char *const stage_names[LED_PROFILE_STAGE_MAX] = {
+    [LED_PROFILE_GLYPH_LOOKUP] = "glyph lookup",
+    [LED_PROFILE_COMPOSE] = "compose",
+    [LED_PROFILE_SCALE] = "scale",
+    [LED_PROFILE_CONVERT] = "convert",
+    [LED_PROFILE_ENCODE] = "encode",
+    [LED_PROFILE_TRANSMIT] = "transmit",
+    [LED_PROFILE_FRAME] = "frame",
+};
+
+// 每个阶段保存最近 CONFIG_LED_PROFILE_SAMPLES 帧的耗时
+typedef struct {
+    uint32_t ring[CONFIG_LED_PROFILE_SAMPLES];
+    uint32_t head;
+    uint32_t count;
+    int64_t frame_ns;   // 本帧累计
+    bool in_frame;      // 本帧是否执行过
+} led_profile_stage_data_t;
+
+static led_profile_stage_data_t stages[LED_PROFILE_STAGE_MAX];
+
+int64_t led_profile_now_ns(void)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+    return esp_timer_get_time() * 1000;
+#endif
+}
+
+void led_profile_add(led_profile_stage_t stage, int64_t ns)
+{
+    stages[stage].frame_ns += ns;
+    stages[stage].in_frame = true;
+}
+
+void led_profile_frame_end(void)
+{
+    for (int i = 0; i < LED_PROFILE_STAGE_MAX; i++) {
+        led_profile_stage_data_t *s = &stages[i];
+        if (!s->in_frame) {
+            continue;
+        }
+        s->ring[s->head] = s->frame_ns > UINT32_MAX ? UINT32_MAX : (uint32_t)s->frame_ns;
+        s->head = (s->head + 1) % CONFIG_LED_PROFILE_SAMPLES;
+        if (s->count < CONFIG_LED_PROFILE_SAMPLES) {
+            s->count++;
+        }
+        s->frame_ns = 0;
+        s->in_frame = false;
+    }
+}
+
+static int led_profile_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+void led_profile_get_summary(led_profile_stage_t stage, led_profile_summary_t *summary)
+{
+    static uint32_t sorted[CONFIG_LED_PROFILE_SAMPLES];
+    const led_profile_stage_data_t *s = &stages[stage];
+    memset(summary, 0, sizeof(*summary));
+    if (s->count == 0) {
+        return;
+    }
+    memcpy(sorted, s->ring, s->count * sizeof(uint32_t));
+    qsort(sorted, s->count, sizeof(uint32_t), led_profile_cmp);
+    summary->samples = s->count;
+    summary->p50_ns = sorted[(s->count - 1) * 50 / 100];
+    summary->p99_ns = sorted[(s->count - 1) * 99 / 100];
+    summary->max_ns = sorted[s->count - 1];
+}
+
+void led_profile_report(void)
+{
+    ESP_LOGI(TAG, "%-12s %7s %10s %10s %10s", "stage", "frames", "p50 ns", "p99 ns", "max ns");
+    for (int i = 0; i < LED_PROFILE_STAGE_MAX; i++) {
+        led_profile_summary_t summary;
+        led_profile_get_summary(i, &summary);
+        if (summary.samples == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "%-12s %7" PRIu32 " %10" PRIu32 " %10" PRIu32 " %10" PRIu32, stage_names[i], summary.samples,
+                 summary.p50_ns, summary.p99_ns, summary.max_ns);
+    }
+}
+
+#endif // CONFIG_LED_PROFILE
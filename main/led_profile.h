@@ -0,0 +1,58 @@
+#ifndef LED_PROFILE_H
+#define LED_PROFILE_H
+
+#include <stdint.h>
+#include "sdkconfig.h"
+
+// 渲染流水线的各个阶段
+typedef enum {
+    LED_PROFILE_GLYPH_LOOKUP,   // 在字模图集中查找字符
+    LED_PROFILE_COMPOSE,        // 清空帧缓冲并绘制字模
+    LED_PROFILE_SCALE,          // 查表完成 gamma、亮度换算并整理成灯带顺序
+    LED_PROFILE_CONVERT,        // 写入灯带缓冲 (led_strip_set_pixels)
+    LED_PROFILE_ENCODE,         // RMT 编码器预编码, 来自编码器统计的 CPU 周期数
+    LED_PROFILE_TRANSMIT,       // 从开始刷新到最后一位发送完成, 包含编码
+    LED_PROFILE_FRAME,          // led_display_time 整体耗时
+    LED_PROFILE_STAGE_MAX,
+} led_profile_stage_t;
+
+/**
+ * @brief Timing summary of one render stage, over the most recent frames
+ */
+typedef struct {
+    uint32_t samples;   /*!< Frames the stage ran in, at most CONFIG_LED_PROFILE_SAMPLES */
+    uint32_t p50_ns;    /*!< Median time per frame, in nanoseconds */
+    uint32_t p99_ns;    /*!< 99th percentile time per frame, in nanoseconds */
+    uint32_t max_ns;    /*!< Longest time per frame, in nanoseconds */
+} led_profile_summary_t;
+
+#if CONFIG_LED_PROFILE
+
+// 单调时钟, 设备上使用 esp_timer_get_time (微秒精度), 主机上使用 CLOCK_MONOTONIC
+int64_t led_profile_now_ns(void);
+
+// 累加本帧某一阶段的耗时, 同一帧内可多次调用
+void led_profile_add(led_profile_stage_t stage, int64_t ns);
+
+// 一帧结束, 把本帧执行过的阶段的耗时写入各自的环形缓冲
+void led_profile_frame_end(void);
+
+void led_profile_get_summary(led_profile_stage_t stage, led_profile_summary_t *summary);
+
+// 打印各阶段的 p50/p99
+void led_profile_report(void);
+
+#define LED_PROFILE_BEGIN(t) int64_t t = led_profile_now_ns()
+#define LED_PROFILE_END(stage, t) led_profile_add(stage, led_profile_now_ns() - (t))
+
+#else
+
+#define LED_PROFILE_BEGIN(t)
+#define LED_PROFILE_END(stage, t)
+static inline void led_profile_add(led_profile_stage_t stage, int64_t ns) {}
+static inline void led_profile_frame_end(void) {}
+static inline void led_profile_report(void) {}
+
+#endif // CONFIG_LED_PROFILE
+
+#endif // LED_PROFILE_H
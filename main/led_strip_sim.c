@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/cdefs.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "led_strip_interface.h"
+#include "led_strip_sim.h"
+#include "led_matrix.h"
+
+static const char *TAG = "led_strip_sim";
+
+typedef struct {
+    led_strip_t base;
+    FILE *record;                               // 原始 RGB 录制文件
+    const char *ppm_dir;                        // 逐帧 PPM 输出目录
+    bool ansi_output;                           // 在终端中绘制
+    uint32_t frames;                            // 已刷新的帧数, 用于 PPM 文件编号
+    uint8_t pixels[LED_STRIP_LED_NUMBERS][3];   // 按灯带顺序的 RGB
+    uint8_t image[PIXEL_HIGHT][PIXEL_WIDTH][3]; // 还原成行优先的画面
+} led_strip_sim_obj;
+
+static esp_err_t led_strip_sim_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    led_strip_sim_obj *sim_strip = __containerof(strip, led_strip_sim_obj, base);
+    ESP_RETURN_ON_FALSE(index < LED_STRIP_LED_NUMBERS, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    sim_strip->pixels[index][0] = red & 0xFF;
+    sim_strip->pixels[index][1] = green & 0xFF;
+    sim_strip->pixels[index][2] = blue & 0xFF;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_sim_set_pixel_rgbw(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    // 面板只有 RGB 灯珠, 白色分量不参与显示
+    return led_strip_sim_set_pixel(strip, index, red, green, blue);
+}
+
+static esp_err_t led_strip_sim_set_pixels(led_strip_t *strip, uint32_t start, const uint8_t *rgb, uint32_t count)
+{
+    led_strip_sim_obj *sim_strip = __containerof(strip, led_strip_sim_obj, base);
+    ESP_RETURN_ON_FALSE(start <= LED_STRIP_LED_NUMBERS && count <= LED_STRIP_LED_NUMBERS - start, ESP_ERR_INVALID_ARG, TAG,
+                        "span out of maximum number of LEDs");
+    memcpy(sim_strip->pixels[start], rgb, count * 3);
+    return ESP_OK;
+}
+
+static void led_strip_sim_draw_ansi(led_strip_sim_obj *sim_strip)
+{
+    // 从第二帧开始把光标移回画面左上角, 原地覆盖上一帧
+    if (sim_strip->frames > 1) {
+        printf("\x1b[%dA", PIXEL_HIGHT);
+    }
+    for (int y = 0; y < PIXEL_HIGHT; y++) {
+        for (int x = 0; x < PIXEL_WIDTH; x++) {
+            const uint8_t *p = sim_strip->image[y][x];
+            printf("\x1b[48;2;%d;%d;%dm  ", p[0], p[1], p[2]);
+        }
+        printf("\x1b[0m\n");
+    }
+    fflush(stdout);
+}
+
+static esp_err_t led_strip_sim_write_ppm(led_strip_sim_obj *sim_strip)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s/frame_%05lu.ppm", sim_strip->ppm_dir, (unsigned long)sim_strip->frames);
+    FILE *f = fopen(path, "wb");
+    ESP_RETURN_ON_FALSE(f, ESP_FAIL, TAG, "open %s failed", path);
+    fprintf(f, "P6\n%d %d\n255\n", PIXEL_WIDTH, PIXEL_HIGHT);
+    size_t written = fwrite(sim_strip->image, sizeof(sim_strip->image), 1, f);
+    fclose(f);
+    ESP_RETURN_ON_FALSE(written == 1, ESP_FAIL, TAG, "write %s failed", path);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_sim_refresh(led_strip_t *strip)
+{
+    led_strip_sim_obj *sim_strip = __containerof(strip, led_strip_sim_obj, base);
+    sim_strip->frames++;
+
+    // 按映射表把灯带顺序还原成画面, 接线方式配置错误时画面会错乱
+    for (int y = 0; y < PIXEL_HIGHT; y++) {
+        for (int x = 0; x < PIXEL_WIDTH; x++) {
+            memcpy(sim_strip->image[y][x], sim_strip->pixels[led_matrix_index(x, y)], 3);
+        }
+    }
+
+    if (sim_strip->record) {
+        ESP_RETURN_ON_FALSE(fwrite(sim_strip->image, sizeof(sim_strip->image), 1, sim_strip->record) == 1, ESP_FAIL, TAG,
+                            "record frame failed");
+        fflush(sim_strip->record);
+    }
+    if (sim_strip->ppm_dir) {
+        ESP_RETURN_ON_ERROR(led_strip_sim_write_ppm(sim_strip), TAG, "dump frame failed");
+    }
+    if (sim_strip->ansi_output) {
+        led_strip_sim_draw_ansi(sim_strip);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_sim_clear(led_strip_t *strip)
+{
+    led_strip_sim_obj *sim_strip = __containerof(strip, led_strip_sim_obj, base);
+    memset(sim_strip->pixels, 0, sizeof(sim_strip->pixels));
+    return led_strip_sim_refresh(strip);
+}
+
+static esp_err_t led_strip_sim_del(led_strip_t *strip)
+{
+    led_strip_sim_obj *sim_strip = __containerof(strip, led_strip_sim_obj, base);
+    if (sim_strip->record) {
+        fclose(sim_strip->record);
+    }
+    free(sim_strip);
+    return ESP_OK;
+}
+
+esp_err_t led_strip_new_sim_device(const led_strip_config_t *led_config, const led_strip_sim_config_t *sim_config,
+                                   led_strip_handle_t *ret_strip)
+{
+    led_strip_sim_obj *sim_strip = NULL;
+    esp_err_t ret = ESP_OK;
+    ESP_RETURN_ON_FALSE(led_config && sim_config && ret_strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(led_config->max_leds == LED_STRIP_LED_NUMBERS, ESP_ERR_INVALID_ARG, TAG,
+                        "simulated strip must cover the whole %dx%d matrix", PIXEL_WIDTH, PIXEL_HIGHT);
+
+    sim_strip = calloc(1, sizeof(led_strip_sim_obj));
+    ESP_RETURN_ON_FALSE(sim_strip, ESP_ERR_NO_MEM, TAG, "no mem for sim strip");
+    if (sim_config->record_path) {
+        sim_strip->record = fopen(sim_config->record_path, "wb");
+        ESP_GOTO_ON_FALSE(sim_strip->record, ESP_FAIL, err, TAG, "open %s failed", sim_config->record_path);
+    }
+    sim_strip->ppm_dir = sim_config->ppm_dir;
+    sim_strip->ansi_output = sim_config->ansi_output;
+
+    sim_strip->base.set_pixel = led_strip_sim_set_pixel;
+    sim_strip->base.set_pixel_rgbw = led_strip_sim_set_pixel_rgbw;
+    sim_strip->base.set_pixels = led_strip_sim_set_pixels;
+    sim_strip->base.refresh = led_strip_sim_refresh;
+    sim_strip->base.clear = led_strip_sim_clear;
+    sim_strip->base.del = led_strip_sim_del;
+    *ret_strip = &sim_strip->base;
+    return ESP_OK;
+err:
+    free(sim_strip);
+    return ret;
+}
@@ -0,0 +1,21 @@
+#ifndef LED_STRIP_SIM_H
+#define LED_STRIP_SIM_H
+
+#include <stdbool.h>
+#include "led_strip.h"
+
+/**
+ * @brief Simulated LED strip configuration, used by the Linux host build
+ */
+typedef struct {
+    const char *record_path;  /*!< File every refreshed frame is appended to as raw RGB, row by row from the top-left pixel. NULL to disable */
+    const char *ppm_dir;      /*!< Directory receiving one frame_NNNNN.ppm image per refresh. NULL to disable */
+    bool ansi_output;         /*!< Draw every refreshed frame in the terminal with 24-bit ANSI colours */
+} led_strip_sim_config_t;
+
+// 创建模拟灯带, 按 led_matrix 的映射把灯带顺序还原成 (x, y) 画面后录制或显示
+// 灯带长度必须等于 PIXEL_WIDTH * PIXEL_HIGHT
+esp_err_t led_strip_new_sim_device(const led_strip_config_t *led_config, const led_strip_sim_config_t *sim_config,
+                                   led_strip_handle_t *ret_strip);
+
+#endif // LED_STRIP_SIM_H
@@ -1,58 +1,214 @@
+#include <inttypes.h>
 #include <stdio.h>
 #include "main.h"
 #include "aic3101.h"
+#include "aic3101_i2s.h"
 #include "ws2812b.h"
+#include "led_profile.h"
+#include "frame_sched.h"
+#include "clock_engine.h"
 #include "sntp.h"
+#include "clock_discipline.h"
+#include "time_checkpoint.h"
+#include "boot_seq.h"
+#include "power_mgr.h"
+#include "spectrum.h"
+#include "dsp_kernels.h"
 #include "wifi.h"
 #include "driver/i2c_master.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "esp_err.h"
+#include "esp_check.h"
 #include "esp_sntp.h"
+#include "nvs_flash.h"
 #include "esp_timer.h"
 #include "time.h"
 
 static const char *TAG = "KaPixel";
 
+// 上电到第一帧的目标时间
+#define FIRST_FRAME_BUDGET_MS 300
 
-// 时间刷新的任务
+
+// 显示任务, 由帧调度器唤醒: 时钟在每个整秒刷新, 频谱按 CONFIG_SPECTRUM_FPS 刷新
 void time_display_task(void* pvParameters) {
     time_t now;
     struct tm timeinfo;
-    time(&now);
-    setenv("TZ", "CST-8", 1);
-    tzset();
-    localtime_r(&now, &timeinfo);
-    
-    time_t last_time = now;  // 使用当前时间初始化last_time
+    clock_engine_init(CONFIG_CLOCK_TIMEZONE);
+
+    if (frame_sched_start(xTaskGetCurrentTaskHandle()) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start frame scheduler");
+        vTaskDelete(NULL);
+        return;
+    }
 
+    bool first_frame = true;
+    bool spectrum_mode = false;
+    time_t last_second = 0;
     while (1) {
+        // 有音乐输入时以动画帧率显示频谱, 静音 CONFIG_SPECTRUM_HOLD_S 秒后回到整秒刷新的时钟
+        if (spectrum_is_active() != spectrum_mode) {
+            spectrum_mode = !spectrum_mode;
+            frame_sched_set_fps(spectrum_mode ? CONFIG_SPECTRUM_FPS : 0);
+            ESP_LOGI(TAG, "Switched to %s", spectrum_mode ? "spectrum" : "clock");
+        }
+
         time(&now);
-        localtime_r(&now, &timeinfo);
+        clock_engine_localtime(now, &timeinfo);
+        bool synced = sntp_service_is_synced();
+        if (spectrum_mode) {
+            spectrum_render();
+        } else {
+            led_display_time(&timeinfo, synced);
+        }
+        if (first_frame) {
+            // esp_timer 从应用启动开始计时, 不含 bootloader 的时间
+            int64_t first_frame_ms = esp_timer_get_time() / 1000;
+            if (first_frame_ms > FIRST_FRAME_BUDGET_MS) {
+                ESP_LOGW(TAG, "First frame %lld ms after boot", first_frame_ms);
+            } else {
+                ESP_LOGI(TAG, "First frame %lld ms after boot", first_frame_ms);
+            }
+            first_frame = false;
+        }
+        if (now == last_second) {
+            frame_sched_wait(portMAX_DELAY);
+            continue;
+        }
+        last_second = now;
+        time_checkpoint_save(synced);
+        clock_discipline_save();
 
-        if (now != last_time) {
-            // 如果秒数变化了，更新LED显示
-            // ESP_LOGI(TAG, "Update Time Display");
-            led_display_time(&timeinfo);
-            last_time = now;
+        if (timeinfo.tm_sec == 0) {
+            led_frame_stats_t stats;
+            led_get_frame_stats(&stats);
+            ESP_LOGD(TAG, "Frames transmitted: %lu, skipped: %lu, encode: %lu cycles / %lu bytes",
+                     stats.transmitted, stats.skipped, stats.last_encode_cycles, stats.last_bytes_encoded);
+            frame_sched_stats_t sched_stats;
+            frame_sched_get_stats(&sched_stats);
+            ESP_LOGD(TAG, "Frame sched: %lu wakeups, %lu frames, jitter avg %lu us / max %ld us, wake latency max %lu us",
+                     sched_stats.wakeups, sched_stats.frames, sched_stats.avg_jitter_us, sched_stats.max_jitter_us,
+                     sched_stats.max_latency_us);
+            power_mgr_stats_t power_stats;
+            power_mgr_get_stats(&power_stats);
+            ESP_LOGD(TAG, "Radio active %lld s, modem sleep %lld s, %lu transitions",
+                     power_stats.time_us[POWER_STATE_ACTIVE] / 1000000, power_stats.time_us[POWER_STATE_MODEM_SLEEP] / 1000000,
+                     power_stats.transitions);
+            spectrum_stats_t spectrum_stats;
+            spectrum_get_stats(&spectrum_stats);
+            ESP_LOGD(TAG, "Spectrum: %lu frames, analysis avg %lu us / max %lu us, render avg %lu us, load %lu.%lu%%, %lu overruns",
+                     spectrum_stats.frames, spectrum_stats.analysis_avg_us, spectrum_stats.analysis_max_us,
+                     spectrum_stats.render_avg_us, spectrum_stats.load_permille / 10, spectrum_stats.load_permille % 10,
+                     spectrum_stats.overruns);
+            ESP_LOGD(TAG, "Spectrum feed load %lu.%lu%%", spectrum_stats.feed_load_permille / 10,
+                     spectrum_stats.feed_load_permille % 10);
+            led_profile_report();
         }
 
-        vTaskDelay(pdMS_TO_TICKS(100));//100ms
+        frame_sched_wait(portMAX_DELAY);
     }
 }
 
-// 定期对时的任务
-void time_sync_task(void* pvParameters) {
-    while (1) {
-        ESP_LOGI(TAG, "Start Time Sync");
-        obtain_time();
-        vTaskDelay(pdMS_TO_TICKS(1000*3600*24)); // 24小时后再次同步时间
+// 启动阶段, 顺序即为 boot_stages 中的下标, 只能依赖排在前面的阶段
+enum {
+    BOOT_NVS,
+    BOOT_TIME,
+    BOOT_LED,
+    BOOT_DISPLAY,
+    BOOT_DISCIPLINE,
+    BOOT_I2C,
+    BOOT_CODEC,
+    BOOT_PA,
+#if CONFIG_AUDIO_STREAM_ENABLE
+    BOOT_AUDIO,
+#endif
+#if CONFIG_DSP_KERNELS_BENCHMARK
+    BOOT_DSP_BENCH,
+#endif
+    BOOT_WIFI,
+    BOOT_POWER,
+    BOOT_SNTP,
+};
+
+static i2c_master_bus_handle_t bus_handle;
+static i2c_master_dev_handle_t codec_handle;
+
+// 配置 Codec I2C
+static audio_codec_i2c_cfg_t codec_i2c_cfg = {
+    .addr = AIC3101_I2C_ADDR,
+    .i2c_bus_handle = &bus_handle,
+    .i2c_device_handle = &codec_handle,
+    .clk_speed = I2C_MASTER_FREQ_HZ,
+};
+
+// 配置 Codec I2S
+static audio_codec_i2s_cfg_t codec_i2s_cfg = {
+    .mclk_pin = I2S_MCLK_PIN,
+    .bclk_pin = I2S_BCLK_PIN,
+    .lrclk_pin = I2S_LRCLK_PIN,
+    .din_pin = I2S_DIN_PIN,
+    .dout_pin = I2S_DOUT_PIN,
+};
+
+// 完整的 Codec 配置
+static audio_codec_cfg_t codec_cfg = {
+    .i2c_cfg = &codec_i2c_cfg,
+    .i2s_cfg = &codec_i2s_cfg,
+    .codec_reset_pin = CODEC_RESET_PIN,
+    .pa_shutdown_pin = PA_SHUTDOWN_PIN,
+};
+
+static esp_err_t boot_nvs(void *arg) {
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        // NVS 分区被截断或版本不同, 擦除后重新初始化
+        ESP_RETURN_ON_ERROR(nvs_flash_erase(), TAG, "erase nvs failed");
+        ret = nvs_flash_init();
     }
+    return ret;
 }
 
-void app_main(void) {
-    wifi_prov();
-    esp_err_t ret;
+static esp_err_t boot_time(void *arg) {
+    time_source_t source = time_checkpoint_restore();
+    ESP_LOGI(TAG, "Boot time source: %d", source);
+    return ESP_OK;
+}
+
+static esp_err_t boot_led(void *arg) {
+#if CONFIG_LED_ENCODER_BENCHMARK
+    // 当前面板和 4 倍大小的面板, 每帧预编码的周期数
+    const uint32_t bench_leds[] = { 256, 1024 };
+    for (int i = 0; i < sizeof(bench_leds) / sizeof(bench_leds[0]); i++) {
+        led_strip_rmt_encoder_bench_t bench;
+        if (led_strip_rmt_encoder_benchmark(bench_leds[i], &bench) == ESP_OK) {
+            // 括号内为相对逐位编码的加速比
+            ESP_LOGI(TAG, "RMT encode %" PRIu32 " LEDs: bytes encoder %" PRIu32 ", cache full %" PRIu32 " (%.1fx), "
+                     "1/16 changed %" PRIu32 " (%.1fx), unchanged %" PRIu32 " (%.1fx) cycles",
+                     bench.leds, bench.bytes_cycles,
+                     bench.full_cycles, (float)bench.bytes_cycles / bench.full_cycles,
+                     bench.partial_cycles, (float)bench.bytes_cycles / bench.partial_cycles,
+                     bench.unchanged_cycles, (float)bench.bytes_cycles / bench.unchanged_cycles);
+        }
+    }
+#endif
+    return led_init();
+}
+
+static esp_err_t boot_display(void *arg) {
+    // 创建每个整秒刷新显示的任务, 启动后立即显示第一帧
+    if (xTaskCreate(time_display_task, "time_display_task", 3072, NULL, 5, NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t boot_discipline(void *arg) {
+    // 恢复上次保存的频率误差, 对时之前就开始修正漂移
+    return clock_discipline_init();
+}
+
+static esp_err_t boot_i2c(void *arg) {
     i2c_master_bus_config_t i2c_bus_config = {
         .clk_source = I2C_CLK_SRC_DEFAULT,
         .i2c_port = PORT_NUMBER,
@@ -60,60 +216,92 @@ void app_main(void) {
         .sda_io_num = I2C_SDA_PIN,
         .glitch_ignore_cnt = 7,
     };
-    i2c_master_bus_handle_t bus_handle;
-    i2c_master_dev_handle_t codec_handle;
-
-    ESP_ERROR_CHECK(i2c_new_master_bus(&i2c_bus_config, &bus_handle));
+    return i2c_new_master_bus(&i2c_bus_config, &bus_handle);
+}
 
-    // 配置 Codec I2C
-    audio_codec_i2c_cfg_t codec_i2c_cfg = {
-        .addr = AIC3101_I2C_ADDR,
-        .i2c_bus_handle = &bus_handle,
-        .i2c_device_handle = &codec_handle,
-        .clk_speed = I2C_MASTER_FREQ_HZ,
-    };
+static esp_err_t boot_codec(void *arg) {
+    ESP_RETURN_ON_ERROR(audio_codec_init(&codec_cfg), TAG, "Failed to initialize audio codec");
+    //Set CODEC to passthrough mode
+    set_line_to_pa_mode(&codec_cfg);
+    return ESP_OK;
+}
 
-    // 配置 Codec I2S
-    audio_codec_i2s_cfg_t codec_i2s_cfg = {
-        .mclk_pin = I2S_MCLK_PIN,
-        .bclk_pin = I2S_BCLK_PIN,
-        .lrclk_pin = I2S_LRCLK_PIN,
-        .din_pin = I2S_DIN_PIN,
-        .dout_pin = I2S_DOUT_PIN,
-    };
+static esp_err_t boot_pa(void *arg) {
+    return enable_pa(&codec_cfg);
+}
 
-    // 完整的 Codec 配置
-    audio_codec_cfg_t codec_cfg = {
-        .i2c_cfg = &codec_i2c_cfg,
-        .i2s_cfg = &codec_i2s_cfg,
-        .codec_reset_pin = CODEC_RESET_PIN,
-        .pa_shutdown_pin = PA_SHUTDOWN_PIN,
+#if CONFIG_AUDIO_STREAM_ENABLE
+static esp_err_t boot_audio(void *arg) {
+    // 全双工 I2S 数据流, 模拟直通保持不变, 数字通路输出静音, 输入用于频谱显示
+    aic3101_i2s_config_t audio_cfg = {
+        .sample_rate = CONFIG_AUDIO_SAMPLE_RATE,
+        .bits_per_sample = CONFIG_AUDIO_BITS_PER_SAMPLE,
+        .latency_us = CONFIG_AUDIO_LATENCY_US,
+        .task_priority = CONFIG_AUDIO_TASK_PRIORITY,
+        .task_core = 1,     // Wi-Fi 在核心 0
+        .analog_bypass = true,
     };
+#if CONFIG_SPECTRUM_ENABLE
+    ESP_RETURN_ON_ERROR(spectrum_init(audio_cfg.sample_rate, AIC3101_I2S_CHANNELS, audio_cfg.bits_per_sample), TAG, "Failed to initialize spectrum");
+    audio_cfg.callback = spectrum_feed;
+#endif
+    return aic3101_i2s_start(&codec_cfg, &audio_cfg);
+}
+#endif
 
-    // 初始化 Codec
-    ret = audio_codec_init(&codec_cfg);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize audio codec: %s", esp_err_to_name(ret));
-        return;
-    }
-
-    ESP_LOGI(TAG, "Audio codec initialized successfully!");
-
-    //Set CODEC to passthrough mode
-    set_line_to_pa_mode(&codec_cfg);
-    enable_pa(&codec_cfg);
+#if CONFIG_DSP_KERNELS_BENCHMARK
+static esp_err_t boot_dsp_bench(void *arg) {
+    // 结果由 dsp_kernels_benchmark 打印
+    dsp_bench_result_t bench[8];
+    dsp_kernels_benchmark(bench, sizeof(bench) / sizeof(bench[0]));
+    return ESP_OK;
+}
+#endif
 
-    if (led_init() != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize LED strip");
-        return;
-    }
+static esp_err_t boot_wifi(void *arg) {
+    // 配网可能一直阻塞到用户完成配置, 不影响其他阶段
+    wifi_prov();
+    return ESP_OK;
+}
 
-    // 创建每秒轮询时间变化的任务
-    xTaskCreate(time_display_task, "time_display_task", 2048, NULL, 5, NULL);
-    // 创建定期更新时间的任务
-    xTaskCreate(time_sync_task, "time_sync_task", 4096, NULL, 5, NULL);
-    
+static esp_err_t boot_power(void *arg) {
+    // 网络空闲时射频进入 modem sleep, 对时前自动唤醒
+    return power_mgr_start();
 }
 
+static esp_err_t boot_sntp(void *arg) {
+    // 常驻 SNTP 服务, 在后台对时
+    return sntp_service_start();
+}
 
+static const boot_stage_t boot_stages[] = {
+    [BOOT_NVS]        = { "nvs",        boot_nvs,        NULL, 0 },
+    [BOOT_TIME]       = { "time",       boot_time,       NULL, BIT(BOOT_NVS) },
+    [BOOT_LED]        = { "led",        boot_led,        NULL, 0 },
+    [BOOT_DISPLAY]    = { "display",    boot_display,    NULL, BIT(BOOT_LED) | BIT(BOOT_TIME) },
+    [BOOT_DISCIPLINE] = { "discipline", boot_discipline, NULL, BIT(BOOT_NVS) },
+    [BOOT_I2C]        = { "i2c",        boot_i2c,        NULL, 0 },
+    [BOOT_CODEC]      = { "codec",      boot_codec,      NULL, BIT(BOOT_I2C) },
+    [BOOT_PA]         = { "pa",         boot_pa,         NULL, BIT(BOOT_CODEC) },
+#if CONFIG_AUDIO_STREAM_ENABLE
+    // I2S 数据流的往返延迟尚未在硬件上测量, 验证之前默认不启动
+    [BOOT_AUDIO]      = { "audio",      boot_audio,      NULL, BIT(BOOT_CODEC) },
+#endif
+#if CONFIG_DSP_KERNELS_BENCHMARK
+    // 与音频无关, 不计入启动就绪时间
+    [BOOT_DSP_BENCH]  = { "dsp_bench",  boot_dsp_bench,  NULL, 0, 0, true },
+#endif
+    // 配网可能一直等待用户, 不计入启动就绪时间, 依赖它的 power 和 sntp 也在后台完成
+    [BOOT_WIFI]       = { "wifi",       boot_wifi,       NULL, BIT(BOOT_NVS), 6144, true },
+    [BOOT_POWER]      = { "power",      boot_power,      NULL, BIT(BOOT_WIFI) },
+    [BOOT_SNTP]       = { "sntp",       boot_sntp,       NULL, BIT(BOOT_POWER) | BIT(BOOT_TIME) | BIT(BOOT_DISCIPLINE) },
+};
 
+void app_main(void) {
+    // 各子系统按依赖关系并行初始化, 显示不需要等待配网和 Codec
+    // 前台阶段完成后就返回, 配网和对时在后台继续
+    if (boot_seq_run(boot_stages, sizeof(boot_stages) / sizeof(boot_stages[0])) != ESP_OK) {
+        ESP_LOGE(TAG, "Some subsystems failed to start");
+    }
+    boot_seq_report();
+}
@@ -0,0 +1,335 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#if CONFIG_IDF_TARGET_LINUX
+// 主机测试直接使用系统的 socket, 对本机的模拟服务器查询
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#else
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+#endif
+#include "ntp_client.h"
+
+static const char *TAG = "ntp_client";
+
+#define NTP_PORT            "123"
+#define NTP_PACKET_SIZE     48
+#define NTP_UNIX_OFFSET     2208988800ULL   // 1900-01-01 到 1970-01-01 的秒数
+#define NTP_BURST_GAP_MS    2000            // 同一服务器两次查询的间隔, 公共服务器会限制更频繁的请求
+
+#define NTP_MODE_CLIENT     3
+#define NTP_MODE_SERVER     4
+#define NTP_VERSION         4
+#define NTP_LI_UNSYNC       3
+
+typedef struct {
+    char host[64];
+    char port[8];
+    int sock;
+    int64_t t1_us;              // 本次请求的发送时间 (系统时间)
+    int64_t t1_mono_us;         // 本次请求的发送时间 (单调时钟), 用于计算往返时间
+    uint8_t origin[8];          // 请求中的发送时间戳, 应答的 originate 字段必须与之相同
+    bool waiting;
+    ntp_sample_t samples[NTP_CLIENT_MAX_BURST];
+    int sample_count;
+    ntp_server_stats_t stats;
+} ntp_server_t;
+
+static ntp_server_t servers[NTP_CLIENT_MAX_SERVERS];
+static int server_count;
+
+static void ntp_put_timestamp(uint8_t *p, int64_t unix_us) {
+    uint32_t sec = (uint32_t)(unix_us / 1000000 + NTP_UNIX_OFFSET);
+    uint32_t frac = (uint32_t)(((uint64_t)(unix_us % 1000000) << 32) / 1000000);
+    for (int i = 0; i < 4; i++) {
+        p[i] = sec >> (24 - i * 8);
+        p[4 + i] = frac >> (24 - i * 8);
+    }
+}
+
+static int64_t ntp_get_timestamp(const uint8_t *p) {
+    uint32_t sec = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+    uint32_t frac = (uint32_t)p[4] << 24 | (uint32_t)p[5] << 16 | (uint32_t)p[6] << 8 | p[7];
+    // 2036 年之后 NTP 秒数回绕, 小于 2^31 视为下一个纪元
+    int64_t unix_sec = (int64_t)sec - NTP_UNIX_OFFSET;
+    if (sec < 0x80000000U) {
+        unix_sec += 0x100000000LL;
+    }
+    return unix_sec * 1000000 + (int64_t)(((uint64_t)frac * 1000000) >> 32);
+}
+
+// 单调时钟, 用于往返时间和超时, 不受对时和 adjtime 影响
+static int64_t ntp_mono_us(void) {
+#if CONFIG_IDF_TARGET_LINUX
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+    return esp_timer_get_time();
+#endif
+}
+
+static int64_t ntp_now_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+esp_err_t ntp_client_init(const char *list) {
+    ESP_RETURN_ON_FALSE(list, ESP_ERR_INVALID_ARG, TAG, "invalid server list");
+    server_count = 0;
+    const char *p = list;
+    while (*p && server_count < NTP_CLIENT_MAX_SERVERS) {
+        while (*p == ',' || *p == ' ') {
+            p++;
+        }
+        size_t len = strcspn(p, ", ");
+        if (len == 0) {
+            break;
+        }
+        ntp_server_t *server = &servers[server_count];
+        memset(server, 0, sizeof(*server));
+        server->sock = -1;
+        const char *colon = memchr(p, ':', len);
+        size_t host_len = colon ? (size_t)(colon - p) : len;
+        ESP_RETURN_ON_FALSE(host_len > 0 && host_len < sizeof(server->host), ESP_ERR_INVALID_ARG, TAG, "invalid host in server list");
+        memcpy(server->host, p, host_len);
+        if (colon) {
+            size_t port_len = len - host_len - 1;
+            ESP_RETURN_ON_FALSE(port_len > 0 && port_len < sizeof(server->port), ESP_ERR_INVALID_ARG, TAG, "invalid port in server list");
+            memcpy(server->port, colon + 1, port_len);
+        } else {
+            strcpy(server->port, NTP_PORT);
+        }
+        server->stats.host = server->host;
+        server_count++;
+        p += len;
+    }
+    ESP_RETURN_ON_FALSE(server_count > 0, ESP_ERR_INVALID_ARG, TAG, "no server configured");
+    ESP_LOGI(TAG, "%d NTP servers configured", server_count);
+    return ESP_OK;
+}
+
+// 每轮重新解析地址, pool.ntp.org 之类的域名每次可能指向不同的服务器
+static void ntp_open_sockets(void) {
+    const struct addrinfo hints = {
+        .ai_family = AF_INET,
+        .ai_socktype = SOCK_DGRAM,
+    };
+    for (int i = 0; i < server_count; i++) {
+        ntp_server_t *server = &servers[i];
+        server->sample_count = 0;
+        struct addrinfo *res = NULL;
+        if (getaddrinfo(server->host, server->port, &hints, &res) != 0 || res == NULL) {
+            ESP_LOGW(TAG, "Failed to resolve %s", server->host);
+            continue;
+        }
+        int sock = socket(res->ai_family, res->ai_socktype, 0);
+        // connect 之后只会收到来自该服务器地址的数据报
+        if (sock >= 0 && connect(sock, res->ai_addr, res->ai_addrlen) != 0) {
+            close(sock);
+            sock = -1;
+        }
+        freeaddrinfo(res);
+        if (sock < 0) {
+            ESP_LOGW(TAG, "Failed to open socket for %s", server->host);
+            continue;
+        }
+        server->sock = sock;
+    }
+}
+
+static void ntp_close_sockets(void) {
+    for (int i = 0; i < server_count; i++) {
+        if (servers[i].sock >= 0) {
+            close(servers[i].sock);
+            servers[i].sock = -1;
+        }
+    }
+}
+
+static void ntp_send_request(ntp_server_t *server) {
+    uint8_t packet[NTP_PACKET_SIZE] = { 0 };
+    packet[0] = NTP_VERSION << 3 | NTP_MODE_CLIENT;
+    server->t1_mono_us = ntp_mono_us();
+    server->t1_us = ntp_now_us();
+    ntp_put_timestamp(&packet[40], server->t1_us);
+    memcpy(server->origin, &packet[40], sizeof(server->origin));
+    server->waiting = send(server->sock, packet, sizeof(packet), 0) == sizeof(packet);
+    if (!server->waiting) {
+        server->stats.timeouts++;
+    }
+}
+
+static void ntp_receive_reply(ntp_server_t *server) {
+    uint8_t packet[NTP_PACKET_SIZE];
+    int len = recv(server->sock, packet, sizeof(packet), 0);
+    // 接收时间由单调时钟的往返时间推算
+    int64_t t4_us = server->t1_us + (ntp_mono_us() - server->t1_mono_us);
+    if (len < 0) {
+        // 例如 ICMP 端口不可达, 这次请求不会再有应答
+        ESP_LOGD(TAG, "%s: recv failed, errno %d", server->host, errno);
+        server->waiting = false;
+        server->stats.timeouts++;
+        return;
+    }
+    uint8_t li = packet[0] >> 6;
+    uint8_t mode = packet[0] & 0x07;
+    uint8_t stratum = packet[1];
+    // 拒绝: 长度或模式不对, 服务器未同步 (LI = 3), stratum 0 为 kiss-o'-death, 以及不是对本次请求的应答
+    if (len < NTP_PACKET_SIZE || mode != NTP_MODE_SERVER || li == NTP_LI_UNSYNC || stratum == 0 || stratum > 15
+        || memcmp(&packet[24], server->origin, sizeof(server->origin)) != 0) {
+        server->stats.rejected++;
+        return;
+    }
+    server->waiting = false;
+    int64_t t2_us = ntp_get_timestamp(&packet[32]);
+    int64_t t3_us = ntp_get_timestamp(&packet[40]);
+    ntp_sample_t *sample = &server->samples[server->sample_count++];
+    sample->offset_us = ((t2_us - server->t1_us) + (t3_us - t4_us)) / 2;
+    sample->delay_us = (t4_us - server->t1_us) - (t3_us - t2_us);
+    if (sample->delay_us < 0) {
+        sample->delay_us = 0;
+    }
+    server->stats.replies++;
+    ESP_LOGD(TAG, "%s: offset %lld us, delay %lld us", server->host,
+             (long long)sample->offset_us, (long long)sample->delay_us);
+}
+
+// 并行向所有服务器发送一次请求, 等待应答直到全部收到或超时
+static void ntp_query_all(void) {
+    int max_fd = -1;
+    for (int i = 0; i < server_count; i++) {
+        if (servers[i].sock >= 0) {
+            ntp_send_request(&servers[i]);
+            if (servers[i].sock > max_fd) {
+                max_fd = servers[i].sock;
+            }
+        }
+    }
+    int64_t deadline_us = ntp_mono_us() + CONFIG_SNTP_QUERY_TIMEOUT_MS * 1000LL;
+    while (max_fd >= 0) {
+        fd_set fds;
+        FD_ZERO(&fds);
+        bool waiting = false;
+        for (int i = 0; i < server_count; i++) {
+            if (servers[i].sock >= 0 && servers[i].waiting) {
+                FD_SET(servers[i].sock, &fds);
+                waiting = true;
+            }
+        }
+        int64_t remaining_us = deadline_us - ntp_mono_us();
+        if (!waiting || remaining_us <= 0) {
+            break;
+        }
+        struct timeval timeout = { .tv_sec = remaining_us / 1000000, .tv_usec = remaining_us % 1000000 };
+        int ready = select(max_fd + 1, &fds, NULL, NULL, &timeout);
+        if (ready < 0 && errno == EINTR) {
+            // 主机上 FreeRTOS 的 tick 信号会打断 select
+            continue;
+        }
+        if (ready <= 0) {
+            break;
+        }
+        for (int i = 0; i < server_count; i++) {
+            if (servers[i].sock >= 0 && FD_ISSET(servers[i].sock, &fds)) {
+                ntp_receive_reply(&servers[i]);
+            }
+        }
+    }
+    for (int i = 0; i < server_count; i++) {
+        if (servers[i].sock >= 0 && servers[i].waiting) {
+            servers[i].waiting = false;
+            servers[i].stats.timeouts++;
+        }
+    }
+}
+
+static int ntp_compare_offset(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+esp_err_t ntp_client_poll(int64_t *offset_us) {
+    ESP_RETURN_ON_FALSE(offset_us, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(server_count > 0, ESP_ERR_INVALID_STATE, TAG, "not initialized");
+
+    ntp_open_sockets();
+    for (int burst = 0; burst < CONFIG_SNTP_BURST; burst++) {
+        if (burst > 0) {
+            vTaskDelay(pdMS_TO_TICKS(NTP_BURST_GAP_MS));
+        }
+        ntp_query_all();
+    }
+    ntp_close_sockets();
+
+    // 时钟滤波: 排队延迟只会让往返时间变长, 延迟最小的样本受网络拥塞的影响最小
+    ntp_server_t *candidates[NTP_CLIENT_MAX_SERVERS];
+    int64_t offsets[NTP_CLIENT_MAX_SERVERS];
+    int count = 0;
+    for (int i = 0; i < server_count; i++) {
+        ntp_server_t *server = &servers[i];
+        if (server->sample_count == 0) {
+            continue;
+        }
+        server->stats.last = server->samples[0];
+        for (int j = 1; j < server->sample_count; j++) {
+            if (server->samples[j].delay_us < server->stats.last.delay_us) {
+                server->stats.last = server->samples[j];
+            }
+        }
+        offsets[count] = server->stats.last.offset_us;
+        candidates[count++] = server;
+    }
+    if (count == 0) {
+        ESP_LOGW(TAG, "No usable reply from any server");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // 选择: 偏差离中位数太远的服务器视为错误的时钟, 剩下的服务器中取延迟最小的
+    // 允许的偏离为固定门限加上样本自身的误差范围 (往返时间的一半)
+    qsort(offsets, count, sizeof(offsets[0]), ntp_compare_offset);
+    int64_t median = count % 2 ? offsets[count / 2] : (offsets[count / 2 - 1] + offsets[count / 2]) / 2;
+    ntp_server_t *best = NULL;
+    for (int i = 0; i < count; i++) {
+        ntp_sample_t *sample = &candidates[i]->stats.last;
+        if (llabs(sample->offset_us - median) > CONFIG_SNTP_OUTLIER_MS * 1000LL + sample->delay_us / 2) {
+            candidates[i]->stats.outliers++;
+            ESP_LOGW(TAG, "%s rejected: offset %lld us, median %lld us", candidates[i]->host,
+                     (long long)sample->offset_us, (long long)median);
+            continue;
+        }
+        if (best == NULL || sample->delay_us < best->stats.last.delay_us) {
+            best = candidates[i];
+        }
+    }
+    if (best == NULL) {
+        ESP_LOGW(TAG, "Servers disagree, no sample selected");
+        return ESP_ERR_NOT_FOUND;
+    }
+    best->stats.selected++;
+    *offset_us = best->stats.last.offset_us;
+    ESP_LOGI(TAG, "Selected %s: offset %lld us, delay %lld us, %d/%d servers", best->host,
+             (long long)best->stats.last.offset_us, (long long)best->stats.last.delay_us, count, server_count);
+    return ESP_OK;
+}
+
+int ntp_client_get_stats(ntp_server_stats_t *stats, int max) {
+    for (int i = 0; i < server_count && i < max; i++) {
+        stats[i] = servers[i].stats;
+    }
+    return server_count;
+}
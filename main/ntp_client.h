@@ -0,0 +1,45 @@
+#ifndef NTP_CLIENT_H
+#define NTP_CLIENT_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// 同时查询的服务器数量上限
+#define NTP_CLIENT_MAX_SERVERS 4
+
+// 每轮对每个服务器连续查询的最大次数
+#define NTP_CLIENT_MAX_BURST 8
+
+/**
+ * @brief One NTP exchange
+ */
+typedef struct {
+    int64_t offset_us;          /*!< Server time minus local time, ((T2 - T1) + (T3 - T4)) / 2 */
+    int64_t delay_us;           /*!< Round-trip delay excluding server processing, (T4 - T1) - (T3 - T2) */
+} ntp_sample_t;
+
+/**
+ * @brief Per-server statistics
+ */
+typedef struct {
+    const char *host;           /*!< Server host name as configured */
+    uint32_t replies;           /*!< Valid replies received */
+    uint32_t timeouts;          /*!< Queries that got no reply, because of a timeout or a send or receive error */
+    uint32_t rejected;          /*!< Replies dropped for a bad header, unsynchronized server or mismatched origin */
+    uint32_t outliers;          /*!< Rounds in which the filtered sample was rejected as a falseticker */
+    uint32_t selected;          /*!< Rounds in which this server's sample set the clock */
+    ntp_sample_t last;          /*!< Filtered (lowest delay) sample of the last round, valid when replies > 0 */
+} ntp_server_stats_t;
+
+// 解析服务器列表 ("host[:port]", 逗号分隔), 只需调用一次
+esp_err_t ntp_client_init(const char *servers);
+
+// 进行一轮查询: 并行向所有服务器连续查询若干次, 每个服务器取延迟最小的样本
+// 剔除与其他服务器偏差过大的样本后, 返回延迟最小的服务器测得的偏差
+// 没有可用的样本时返回 ESP_ERR_NOT_FOUND, 此函数不修改系统时间
+esp_err_t ntp_client_poll(int64_t *offset_us);
+
+// 返回服务器数量, 最多写入 max 个统计
+int ntp_client_get_stats(ntp_server_stats_t *stats, int max);
+
+#endif // NTP_CLIENT_H
@@ -0,0 +1,143 @@
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "power_mgr.h"
+
+static const char *TAG = "power_mgr";
+
+static SemaphoreHandle_t power_lock;
+static esp_timer_handle_t wake_start_timer;
+static esp_timer_handle_t wake_end_timer;
+static uint32_t hold_count;
+static bool wake_held;              // 预约唤醒占用了一次 hold
+static int64_t wake_start_us;       // 预约的唤醒时段 [start, end) (esp_timer 时基), 没有预约时为空
+static int64_t wake_end_us;
+static int64_t state_since_us;
+static power_mgr_stats_t power_stats;
+
+// 调用时已持有 power_lock
+static void power_mgr_apply(void) {
+    power_state_t state = hold_count > 0 ? POWER_STATE_ACTIVE : POWER_STATE_MODEM_SLEEP;
+    if (state == power_stats.state) {
+        return;
+    }
+    esp_err_t err = esp_wifi_set_ps(state == POWER_STATE_ACTIVE ? WIFI_PS_NONE : WIFI_PS_MAX_MODEM);
+    if (err != ESP_OK) {
+        // 与蓝牙共存时不允许关闭 modem sleep, 保持原状态
+        ESP_LOGW(TAG, "Failed to set power save mode: %s", esp_err_to_name(err));
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    power_stats.time_us[power_stats.state] += now - state_since_us;
+    state_since_us = now;
+    power_stats.state = state;
+    power_stats.transitions++;
+    ESP_LOGD(TAG, "Radio %s", state == POWER_STATE_ACTIVE ? "active" : "in modem sleep");
+}
+
+void power_mgr_acquire(void) {
+    if (power_lock == NULL) {
+        return;
+    }
+    xSemaphoreTake(power_lock, portMAX_DELAY);
+    hold_count++;
+    power_mgr_apply();
+    xSemaphoreGive(power_lock);
+}
+
+void power_mgr_release(void) {
+    if (power_lock == NULL) {
+        return;
+    }
+    xSemaphoreTake(power_lock, portMAX_DELAY);
+    if (hold_count > 0) {
+        hold_count--;
+    }
+    power_mgr_apply();
+    xSemaphoreGive(power_lock);
+}
+
+// 调用时已持有 power_lock, 按当前时间是否在预约的唤醒时段内占用或释放一次 hold
+static void power_mgr_update_wake(void) {
+    int64_t now = esp_timer_get_time();
+    bool want = now >= wake_start_us && now < wake_end_us;
+    if (want == wake_held) {
+        return;
+    }
+    wake_held = want;
+    if (want) {
+        hold_count++;
+        power_stats.scheduled_wakes++;
+    } else if (hold_count > 0) {
+        hold_count--;
+    }
+    power_mgr_apply();
+}
+
+// 唤醒时段的开始和结束各由一个单次定时器触发, 空闲时没有定时器唤醒 CPU
+// 两个定时器共用回调, 按时间重新判断, 被新预约取代的回调不会误触发
+static void power_mgr_wake_cb(void *arg) {
+    xSemaphoreTake(power_lock, portMAX_DELAY);
+    power_mgr_update_wake();
+    xSemaphoreGive(power_lock);
+}
+
+void power_mgr_schedule_wake(uint32_t delay_s) {
+    if (power_lock == NULL) {
+        return;
+    }
+    xSemaphoreTake(power_lock, portMAX_DELAY);
+    esp_timer_stop(wake_start_timer);
+    esp_timer_stop(wake_end_timer);
+    int64_t now = esp_timer_get_time();
+    wake_start_us = now + (delay_s - (int64_t)CONFIG_POWER_MGR_WAKE_AHEAD_S) * 1000000LL;
+    wake_end_us = wake_start_us + CONFIG_POWER_MGR_WAKE_WINDOW_S * 1000000LL;
+    if (wake_start_us > now) {
+        esp_timer_start_once(wake_start_timer, wake_start_us - now);
+    }
+    if (wake_end_us > now) {
+        esp_timer_start_once(wake_end_timer, wake_end_us - now);
+    }
+    // 新的预约替换旧的预约: 正在进行的唤醒结束, 时段已经开始时立即唤醒
+    power_mgr_update_wake();
+    xSemaphoreGive(power_lock);
+}
+
+esp_err_t power_mgr_start(void) {
+    ESP_RETURN_ON_FALSE(power_lock == NULL, ESP_ERR_INVALID_STATE, TAG, "already started");
+    power_lock = xSemaphoreCreateMutex();
+    ESP_RETURN_ON_FALSE(power_lock, ESP_ERR_NO_MEM, TAG, "no mem for lock");
+    const esp_timer_create_args_t start_args = {
+        .callback = power_mgr_wake_cb,
+        .name = "power_wake_start",
+    };
+    const esp_timer_create_args_t end_args = {
+        .callback = power_mgr_wake_cb,
+        .name = "power_wake_end",
+    };
+    ESP_RETURN_ON_ERROR(esp_timer_create(&start_args, &wake_start_timer), TAG, "create timer failed");
+    ESP_RETURN_ON_ERROR(esp_timer_create(&end_args, &wake_end_timer), TAG, "create timer failed");
+
+    xSemaphoreTake(power_lock, portMAX_DELAY);
+    state_since_us = esp_timer_get_time();
+    power_stats.state = POWER_STATE_ACTIVE;
+    power_mgr_apply();
+    xSemaphoreGive(power_lock);
+    ESP_LOGI(TAG, "Power manager started, listen interval %d", CONFIG_POWER_MGR_LISTEN_INTERVAL);
+    return ESP_OK;
+}
+
+void power_mgr_get_stats(power_mgr_stats_t *stats) {
+    if (power_lock == NULL) {
+        *stats = power_stats;
+        return;
+    }
+    xSemaphoreTake(power_lock, portMAX_DELAY);
+    *stats = power_stats;
+    stats->time_us[power_stats.state] += esp_timer_get_time() - state_since_us;
+    xSemaphoreGive(power_lock);
+}
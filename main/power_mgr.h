@@ -0,0 +1,41 @@
+#ifndef POWER_MGR_H
+#define POWER_MGR_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @brief Radio power state
+ */
+typedef enum {
+    POWER_STATE_ACTIVE,         /*!< Radio always on (WIFI_PS_NONE), used while a sync or other traffic is expected */
+    POWER_STATE_MODEM_SLEEP,    /*!< Radio wakes only every listen interval (WIFI_PS_MAX_MODEM) */
+    POWER_STATE_MAX,
+} power_state_t;
+
+/**
+ * @brief Power manager statistics
+ */
+typedef struct {
+    int64_t time_us[POWER_STATE_MAX];   /*!< Time spent in each state since power_mgr_start */
+    uint32_t transitions;               /*!< State changes */
+    uint32_t scheduled_wakes;           /*!< Wake-ups ahead of a scheduled sync */
+    power_state_t state;                /*!< Current state */
+} power_mgr_stats_t;
+
+// 连上 Wi-Fi 之后调用, 没有唤醒请求时进入 modem sleep
+// 只控制射频, CPU 不进入 light sleep: LED 的 RMT 通道和音频的 I2S 通道一直持有电源锁
+// 节省的电流尚未在硬件上测量, 统计只记录各状态的时间
+esp_err_t power_mgr_start(void);
+
+// 需要低延迟收发时保持射频常开, 与 power_mgr_release 成对调用, 可以嵌套
+void power_mgr_acquire(void);
+void power_mgr_release(void);
+
+// 预约 delay_s 秒之后的一次网络活动 (如对时), 提前 CONFIG_POWER_MGR_WAKE_AHEAD_S 秒唤醒射频
+// 保持 CONFIG_POWER_MGR_WAKE_WINDOW_S 秒, 新的预约替换旧的预约
+void power_mgr_schedule_wake(uint32_t delay_s);
+
+void power_mgr_get_stats(power_mgr_stats_t *stats);
+
+#endif // POWER_MGR_H
@@ -0,0 +1,56 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "ws2812b.h"
+#include "led_profile.h"
+#include "clock_engine.h"
+
+static const char *TAG = "KaPixel-sim";
+
+static int64_t sim_time_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// 主机仿真入口: 逐秒渲染时钟画面, 录制每一帧并统计每帧的渲染耗时
+void app_main(void)
+{
+    if (led_init() != ESP_OK) {
+        exit(1);
+    }
+
+    time_t now = CONFIG_LED_SIM_START_TIME;
+    if (now == 0) {
+        time(&now);
+    }
+    clock_engine_init(CONFIG_CLOCK_TIMEZONE);
+
+    int64_t total_ns = 0;
+    int64_t max_ns = 0;
+    for (int i = 0; i < CONFIG_LED_SIM_FRAMES; i++, now++) {
+        struct tm timeinfo;
+        clock_engine_localtime(now, &timeinfo);
+
+        int64_t start = sim_time_ns();
+        led_display_time(&timeinfo, true);
+        int64_t cost = sim_time_ns() - start;
+
+        total_ns += cost;
+        if (cost > max_ns) {
+            max_ns = cost;
+        }
+    }
+
+    led_frame_stats_t stats;
+    led_get_frame_stats(&stats);
+    ESP_LOGI(TAG, "%" PRIu32 " frames, %" PRIu32 " transmitted, %" PRIu32 " skipped", stats.frames, stats.transmitted, stats.skipped);
+    // 耗时包含模拟灯带的录制和终端输出, 对比渲染开销时应关闭这两项
+    ESP_LOGI(TAG, "render cost per frame: avg %" PRId64 " ns, max %" PRId64 " ns",
+             total_ns / CONFIG_LED_SIM_FRAMES, max_ns);
+    led_profile_report();
+    exit(0);
+}
@@ -6,18 +6,27 @@
    software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
    CONDITIONS OF ANY KIND, either express or implied.
 */
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <sys/time.h>
 #include "esp_system.h"
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_check.h"
 #include "esp_attr.h"
-#include "esp_sleep.h"
-#include "nvs_flash.h"
+#include "esp_timer.h"
 #include "esp_netif_sntp.h"
 #include "lwip/ip_addr.h"
 #include "esp_sntp.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "clock_engine.h"
+#include "clock_discipline.h"
+#include "clock_servo.h"
+#include "ntp_client.h"
+#include "power_mgr.h"
+#include "sntp.h"
 
 static const char *TAG = "SNTP";
 
@@ -25,98 +34,111 @@ static const char *TAG = "SNTP";
 #define INET6_ADDRSTRLEN 48
 #endif
 
-/* Variable holding number of times ESP32 restarted since first boot.
- * It is placed into RTC memory using RTC_DATA_ATTR and
- * maintains its value when ESP32 wakes from deep sleep.
- */
-RTC_DATA_ATTR static int boot_count = 0;
+static bool service_started = false;
+static sntp_service_stats_t service_stats;
+static int64_t last_sync_us;        // 上一次对时的单调时间 (esp_timer), 用于计算漂移
+static clock_servo_interval_t servo;
 
-// static void obtain_time(void);
-
-#ifdef CONFIG_SNTP_TIME_SYNC_METHOD_CUSTOM
-void sntp_sync_time(struct timeval *tv)
+static int64_t timeval_to_us(const struct timeval *tv)
 {
-   settimeofday(tv, NULL);
-   ESP_LOGI(TAG, "Time is synchronized from custom code");
-   sntp_set_sync_status(SNTP_SYNC_STATUS_COMPLETED);
+    return (int64_t)tv->tv_sec * 1000000L + tv->tv_usec;
 }
-#endif
 
-void time_sync_notification_cb(struct timeval *tv)
+// 根据本次测得的偏差更新漂移估计, 并选出下一次对时的间隔
+static void sntp_service_update(int64_t offset_us)
 {
-    ESP_LOGI(TAG, "Notification of a time synchronization event");
+    int64_t now_us = esp_timer_get_time();
+    // adjtime 尚未完成的部分是上一次的校正, 不属于这段时间的漂移
+    struct timeval pending;
+    adjtime(NULL, &pending);
+    int64_t drift_us = offset_us - timeval_to_us(&pending);
+
+    service_stats.syncs++;
+    service_stats.last_offset_ms = drift_us / 1000;
+    if (service_stats.syncs > 1) {
+        if (abs(service_stats.last_offset_ms) > abs(service_stats.max_offset_ms)) {
+            service_stats.max_offset_ms = service_stats.last_offset_ms;
+        }
+        // 剩余漂移交给时钟校准模块修正频率估计, 估计越准剩余漂移越小, 对时间隔随之变长
+        clock_discipline_sample(drift_us, now_us - last_sync_us);
+    }
+    if (clock_servo_next_interval(&servo, drift_us, now_us - last_sync_us)) {
+        service_stats.budget_exceeded++;
+    }
+    service_stats.drift_ppm = servo.drift_ppm;
+    service_stats.interval_s = servo.interval_s;
+#ifdef CONFIG_SNTP_CLIENT_LWIP
+    // 在对时回调中设置, 作用于 SNTP 安排的下一次请求
+    sntp_set_sync_interval(servo.interval_s * 1000);
+    // 对时前提前唤醒射频, modem sleep 中 AP 缓存的应答会带来不对称的延迟
+    power_mgr_schedule_wake(servo.interval_s);
+#endif
+    last_sync_us = now_us;
+    time(&service_stats.last_sync);
+    ESP_LOGI(TAG, "Offset %ld ms, drift %.2f ppm, next sync in %lu s",
+             service_stats.last_offset_ms, service_stats.drift_ppm, service_stats.interval_s);
 }
 
-void get_ntp_time(void)
+// 按测得的偏差校准系统时间, tv 为校准后的时间, 返回 true 表示通过 adjtime 平滑调整
+static bool sntp_service_correct(int64_t offset_us, const struct timeval *tv)
 {
-    ++boot_count;
-    ESP_LOGI(TAG, "Boot count: %d", boot_count);
-
-    time_t now;
-    struct tm timeinfo;
-    time(&now);
-    localtime_r(&now, &timeinfo);
-    // Is time set? If not, tm_year will be (1970 - 1900).
-    if (timeinfo.tm_year < (2016 - 1900)) {
-        ESP_LOGI(TAG, "Time is not set yet. Connecting to WiFi and getting time over NTP.");
-        // obtain_time();
-        // update 'now' variable with current time
-        time(&now);
-    }
-#ifdef CONFIG_SNTP_TIME_SYNC_METHOD_SMOOTH
-    else {
-        // add 500 ms error to the current system time.
-        // Only to demonstrate a work of adjusting method!
-        {
-            ESP_LOGI(TAG, "Add a error for test adjtime");
-            struct timeval tv_now;
-            gettimeofday(&tv_now, NULL);
-            int64_t cpu_time = (int64_t)tv_now.tv_sec * 1000000L + (int64_t)tv_now.tv_usec;
-            int64_t error_time = cpu_time + 500 * 1000L;
-            struct timeval tv_error = { .tv_sec = error_time / 1000000L, .tv_usec = error_time % 1000000L };
-            settimeofday(&tv_error, NULL);
-        }
+    sntp_service_update(offset_us);
 
-        ESP_LOGI(TAG, "Time was set, now just adjusting it. Use SMOOTH SYNC method.");
-        obtain_time();
-        // update 'now' variable with current time
-        time(&now);
+#ifdef CONFIG_SNTP_TIME_SYNC_METHOD_SMOOTH
+    // 偏差较小时平滑调整, 显示不会跳秒
+    if (service_stats.syncs > 1 && llabs(offset_us) < CONFIG_SNTP_STEP_THRESHOLD_MS * 1000L) {
+        clock_discipline_adjtime_set(offset_us);
+        return true;
     }
 #endif
+    settimeofday(tv, NULL);
+    return false;
+}
 
-    char strftime_buf[64];
-
-    // Set timezone to Eastern Standard Time and print local time
-    setenv("TZ", "EST5EDT,M3.2.0/2,M11.1.0", 1);
-    tzset();
-    localtime_r(&now, &timeinfo);
-    strftime(strftime_buf, sizeof(strftime_buf), "%c", &timeinfo);
-    ESP_LOGI(TAG, "The current date/time in New York is: %s", strftime_buf);
-
-    // Set timezone to China Standard Time
-    setenv("TZ", "CST-8", 1);
-    tzset();
-    localtime_r(&now, &timeinfo);
-    strftime(strftime_buf, sizeof(strftime_buf), "%c", &timeinfo);
-    ESP_LOGI(TAG, "The current date/time in Shanghai is: %s", strftime_buf);
-
-    if (sntp_get_sync_mode() == SNTP_SYNC_MODE_SMOOTH) {
-        struct timeval outdelta;
-        while (sntp_get_sync_status() == SNTP_SYNC_STATUS_IN_PROGRESS) {
-            adjtime(NULL, &outdelta);
-            ESP_LOGI(TAG, "Waiting for adjusting time ... outdelta = %jd sec: %li ms: %li us",
-                        (intmax_t)outdelta.tv_sec,
-                        outdelta.tv_usec/1000,
-                        outdelta.tv_usec%1000);
-            vTaskDelay(2000 / portTICK_PERIOD_MS);
-        }
+// 覆盖 lwip 的弱定义, 在设置系统时间之前测量偏差
+void sntp_sync_time(struct timeval *tv)
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    int64_t offset_us = timeval_to_us(tv) - timeval_to_us(&now);
+    if (sntp_service_correct(offset_us, tv)) {
+        sntp_set_sync_status(SNTP_SYNC_STATUS_IN_PROGRESS);
+    } else {
+        sntp_set_sync_status(SNTP_SYNC_STATUS_COMPLETED);
     }
+}
 
-    const int deep_sleep_sec = 10;
-    ESP_LOGI(TAG, "Entering deep sleep for %d seconds", deep_sleep_sec);
-    esp_deep_sleep(1000000LL * deep_sleep_sec);
+void time_sync_notification_cb(struct timeval *tv)
+{
+    ESP_LOGI(TAG, "Notification of a time synchronization event");
+    // 系统时间可能发生了跳变, 显示用的本地时间需要重新完整换算
+    clock_engine_invalidate();
 }
 
+#ifdef CONFIG_SNTP_CLIENT_MULTI
+// 多服务器模式: 每轮并行查询所有服务器, 经过滤波和筛选之后才校准时间
+static void sntp_service_task(void *arg)
+{
+    while (1) {
+        uint32_t interval_s = CONFIG_SNTP_MIN_INTERVAL_S;
+        int64_t offset_us;
+        // 查询期间保持射频常开, modem sleep 中 AP 缓存的应答会带来不对称的延迟
+        power_mgr_acquire();
+        esp_err_t err = ntp_client_poll(&offset_us);
+        power_mgr_release();
+        if (err == ESP_OK) {
+            struct timeval now;
+            gettimeofday(&now, NULL);
+            int64_t target_us = timeval_to_us(&now) + offset_us;
+            struct timeval tv = { .tv_sec = target_us / 1000000L, .tv_usec = target_us % 1000000L };
+            sntp_service_correct(offset_us, &tv);
+            time_sync_notification_cb(&tv);
+            interval_s = service_stats.interval_s;
+        }
+        vTaskDelay(interval_s * configTICK_RATE_HZ);
+    }
+}
+#else
 static void print_servers(void)
 {
     ESP_LOGI(TAG, "List of configured NTP servers:");
@@ -133,13 +155,19 @@ static void print_servers(void)
         }
     }
 }
+#endif
 
-void obtain_time(void)
+esp_err_t sntp_service_start(void)
 {
-    // ESP_ERROR_CHECK(nvs_flash_init() );
-    // ESP_ERROR_CHECK(esp_netif_init());
-    // ESP_ERROR_CHECK(esp_event_loop_create_default() );
+    if (service_started) {
+        return ESP_OK;
+    }
 
+#ifdef CONFIG_SNTP_CLIENT_MULTI
+    ESP_RETURN_ON_ERROR(ntp_client_init(CONFIG_SNTP_SERVERS), TAG, "ntp client init failed");
+    ESP_RETURN_ON_FALSE(xTaskCreate(sntp_service_task, "sntp_service", 4096, NULL, 4, NULL) == pdPASS,
+                        ESP_ERR_NO_MEM, TAG, "create sntp task failed");
+#else
 #if LWIP_DHCP_GET_NTP_SRV
     /**
      * NTP server address could be acquired via DHCP,
@@ -163,7 +191,7 @@ void obtain_time(void)
     config.ip_event_to_renew = IP_EVENT_ETH_GOT_IP;
 #endif
     config.sync_cb = time_sync_notification_cb; // only if we need the notification function
-    esp_netif_sntp_init(&config);
+    ESP_RETURN_ON_ERROR(esp_netif_sntp_init(&config), TAG, "sntp init failed");
 
 #endif /* LWIP_DHCP_GET_NTP_SRV */
 
@@ -204,22 +232,23 @@ void obtain_time(void)
     config.smooth_sync = true;
 #endif
 
-    esp_netif_sntp_init(&config);
+    ESP_RETURN_ON_ERROR(esp_netif_sntp_init(&config), TAG, "sntp init failed");
 #endif
 
     print_servers();
+    // 第一次对时在启动之后立即进行
+    power_mgr_schedule_wake(0);
+#endif
+    service_started = true;
+    return ESP_OK;
+}
 
-    // wait for time to be set
-    time_t now = 0;
-    struct tm timeinfo = { 0 };
-    int retry = 0;
-    const int retry_count = 15;
-    while (esp_netif_sntp_sync_wait(2000 / portTICK_PERIOD_MS) == ESP_ERR_TIMEOUT && ++retry < retry_count) {
-        ESP_LOGI(TAG, "Waiting for system time to be set... (%d/%d)", retry, retry_count);
-    }
-    time(&now);
-    localtime_r(&now, &timeinfo);
+bool sntp_service_is_synced(void)
+{
+    return service_stats.syncs > 0;
+}
 
-    // ESP_ERROR_CHECK( example_disconnect() );
-    esp_netif_sntp_deinit();
-}
\ No newline at end of file
+void sntp_service_get_stats(sntp_service_stats_t *stats)
+{
+    *stats = service_stats;
+}
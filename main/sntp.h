@@ -1,2 +1,29 @@
-// void get_ntp_time(void);
-void obtain_time(void);
\ No newline at end of file
+#ifndef SNTP_H
+#define SNTP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "esp_err.h"
+
+/**
+ * @brief SNTP service statistics
+ */
+typedef struct {
+    uint32_t syncs;             /*!< Replies applied to the system clock since start */
+    int32_t last_offset_ms;     /*!< Clock error found by the last sync, excluding corrections still being slewed, in milliseconds */
+    int32_t max_offset_ms;      /*!< Largest error found by any sync after the first one */
+    float drift_ppm;            /*!< Smoothed estimate of the clock drift, positive when the local clock runs slow */
+    uint32_t interval_s;        /*!< Interval chosen for the next sync */
+    uint32_t budget_exceeded;   /*!< Syncs that found an error above CONFIG_SNTP_ERROR_BUDGET_MS */
+    time_t last_sync;           /*!< System time of the last sync */
+} sntp_service_stats_t;
+
+// 启动常驻的 SNTP 服务, 只初始化一次, 之后在后台按漂移估计自动选择对时间隔
+esp_err_t sntp_service_start(void);
+
+bool sntp_service_is_synced(void);
+
+void sntp_service_get_stats(sntp_service_stats_t *stats);
+
+#endif // SNTP_H
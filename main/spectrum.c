@@ -0,0 +1,290 @@
+#include <math.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "ws2812b.h"
+#include "dsp_kernels.h"
+#include "spectrum.h"
+
+static const char *TAG = "spectrum";
+
+// 正弦满幅输入经 Hann 窗 (相干增益 0.5) 和共 1/N 的缩放后, 峰值频点的幅度约为 32767 / 4
+#define FULL_SCALE_POWER (8192.0f * 8192.0f)
+
+#define FRAME_PERIOD_US (1000000 / CONFIG_SPECTRUM_FPS)
+
+// 频带检测器的输出: 通带内的满幅正弦均方值为 0.5
+#define FULL_SCALE_MEAN_SQUARE 0.5f
+
+#if !CONFIG_SPECTRUM_STYLE_AMBIENT
+// Q15 Hann 窗, 只乘实数采样
+static int16_t window[SPECTRUM_FFT_SIZE] DSP_ALIGNED;
+static dsp_fft_plan_t fft_plan;
+static uint16_t band_start[SPECTRUM_BANDS + 1];     // 每个频带的第一个频点, 最后一项为结束频点
+#endif
+
+// 音频任务写入, 显示任务读取
+static portMUX_TYPE ring_lock = portMUX_INITIALIZER_UNLOCKED;
+#if !CONFIG_SPECTRUM_STYLE_AMBIENT
+static int16_t ring[SPECTRUM_FFT_SIZE];
+static uint32_t ring_pos;
+#endif
+static uint8_t sample_channels;
+static uint8_t sample_bits;
+static int32_t gate_amplitude;
+static volatile bool loud_seen;
+static volatile uint32_t last_loud_ms;
+
+#if CONFIG_SPECTRUM_STYLE_AMBIENT
+// 环境模式只测低音、中音、高音三个频带的能量, 不做 FFT
+enum {
+    AMBIENT_BASS,
+    AMBIENT_MID,
+    AMBIENT_TREBLE,
+    AMBIENT_BANDS,
+};
+static dsp_band_bank_t band_bank;                   // 只在音频任务中使用
+static float band_energy[AMBIENT_BANDS];            // 输出平方和的累加, 受 ring_lock 保护
+static uint32_t band_samples;
+static uint16_t ambient_levels[AMBIENT_BANDS];      // 0 ~ LED_SPECTRUM_ONE
+#endif
+
+// 音频任务中 spectrum_feed 的耗时, 受 ring_lock 保护
+static uint32_t audio_sample_rate;
+static uint64_t feed_total_us;
+static uint64_t feed_frames;
+
+#if !CONFIG_SPECTRUM_STYLE_AMBIENT
+static int16_t sample_buf[SPECTRUM_FFT_SIZE] DSP_ALIGNED;
+static dsp_cq15_t fft_buf[SPECTRUM_FFT_SIZE];
+static uint32_t power[SPECTRUM_FFT_SIZE / 2];
+static uint16_t levels[SPECTRUM_BANDS];             // 1/LED_SPECTRUM_ONE 像素
+static uint16_t peaks[SPECTRUM_BANDS];
+static uint16_t peak_age[SPECTRUM_BANDS];           // 峰值保持了多少帧
+#endif
+
+static uint64_t analysis_total_us;
+static uint64_t render_total_us;
+static spectrum_stats_t spectrum_stats;
+
+esp_err_t spectrum_init(uint32_t sample_rate, uint8_t channels, uint8_t bits_per_sample) {
+    ESP_RETURN_ON_FALSE(sample_rate >= 8000, ESP_ERR_INVALID_ARG, TAG, "sample rate too low");
+    ESP_RETURN_ON_FALSE(channels == 1 || channels == 2, ESP_ERR_INVALID_ARG, TAG, "unsupported channel count");
+    ESP_RETURN_ON_FALSE(bits_per_sample == 16 || bits_per_sample == 24 || bits_per_sample == 32,
+                        ESP_ERR_INVALID_ARG, TAG, "unsupported bits per sample");
+    sample_channels = channels;
+    sample_bits = bits_per_sample;
+    audio_sample_rate = sample_rate;
+    gate_amplitude = 32767.0f * powf(10.0f, CONFIG_SPECTRUM_GATE_DB / 20.0f);
+    float max_hz = fminf(CONFIG_SPECTRUM_MAX_HZ, sample_rate / 2.0f);
+
+#if CONFIG_SPECTRUM_STYLE_AMBIENT
+    // 带通滤波器的上沿需要低于奈奎斯特频率. 各边沿从上往下依次限制, 每个频带至少一个倍频程宽,
+    // 这样任何 Kconfig 取值和采样率组合都能设计出滤波器
+    float top_hz = fminf(max_hz, sample_rate * 0.45f);
+    float treble_hz = fminf(CONFIG_AMBIENT_TREBLE_HZ, top_hz / 2.0f);
+    float bass_hz = fminf(CONFIG_AMBIENT_BASS_HZ, treble_hz / 2.0f);
+    float low_hz = fminf(CONFIG_SPECTRUM_MIN_HZ, bass_hz / 2.0f);
+    if (treble_hz < CONFIG_AMBIENT_TREBLE_HZ || bass_hz < CONFIG_AMBIENT_BASS_HZ || low_hz < CONFIG_SPECTRUM_MIN_HZ) {
+        ESP_LOGW(TAG, "Ambient band edges lowered to fit below %.0f Hz", top_hz);
+    }
+    const dsp_band_spec_t specs[AMBIENT_BANDS] = {
+        [AMBIENT_BASS]   = { low_hz, bass_hz },
+        [AMBIENT_MID]    = { bass_hz, treble_hz },
+        [AMBIENT_TREBLE] = { treble_hz, top_hz },
+    };
+    ESP_RETURN_ON_ERROR(dsp_band_bank_init(&band_bank, sample_rate, specs, AMBIENT_BANDS), TAG, "Failed to design band filters");
+    ESP_LOGI(TAG, "Ambient bands: bass %.0f-%.0f Hz, mid < %.0f Hz, treble < %.0f Hz", low_hz, bass_hz,
+             treble_hz, top_hz);
+#else
+    ESP_RETURN_ON_ERROR(dsp_fft_plan_init(&fft_plan, SPECTRUM_FFT_SIZE), TAG, "Failed to create FFT plan");
+
+    for (int i = 0; i < SPECTRUM_FFT_SIZE; i++) {
+        window[i] = lroundf(32767.0f * (0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / SPECTRUM_FFT_SIZE)));
+    }
+
+    // 频带按对数均匀分布, 低频的频带不足一个频点时依次后移, 保证每个频带至少有一个频点
+    float bin_hz = (float)sample_rate / SPECTRUM_FFT_SIZE;
+    float ratio = max_hz / CONFIG_SPECTRUM_MIN_HZ;
+    for (int b = 0; b <= SPECTRUM_BANDS; b++) {
+        int bin = lroundf(CONFIG_SPECTRUM_MIN_HZ * powf(ratio, (float)b / SPECTRUM_BANDS) / bin_hz);
+        if (bin < 1) {
+            bin = 1;
+        }
+        if (b > 0 && bin <= band_start[b - 1]) {
+            bin = band_start[b - 1] + 1;
+        }
+        band_start[b] = bin < SPECTRUM_FFT_SIZE / 2 ? bin : SPECTRUM_FFT_SIZE / 2;
+    }
+    ESP_LOGI(TAG, "%d bands from %.0f Hz to %.0f Hz, %.1f Hz per bin", SPECTRUM_BANDS,
+             band_start[0] * bin_hz, band_start[SPECTRUM_BANDS] * bin_hz, bin_hz);
+#endif
+    return ESP_OK;
+}
+
+void spectrum_feed(const void *in, void *out, size_t frames, void *user_ctx) {
+    const int16_t *in16 = in;
+    const int32_t *in32 = in;
+    int64_t start = esp_timer_get_time();
+    int32_t peak = 0;
+#if CONFIG_SPECTRUM_STYLE_AMBIENT
+    // 滤波在锁外进行, 先累加到局部变量, 再在锁内并入显示任务读取的总和
+    float energy[AMBIENT_BANDS] = { 0 };
+    dsp_band_bank_accumulate(&band_bank, in, frames, sample_channels, sample_bits, energy);
+#endif
+    portENTER_CRITICAL(&ring_lock);
+#if CONFIG_SPECTRUM_STYLE_AMBIENT
+    for (int b = 0; b < AMBIENT_BANDS; b++) {
+        band_energy[b] += energy[b];
+    }
+    band_samples += frames;
+#endif
+    for (size_t i = 0; i < frames; i++) {
+        // 单声道的采样直接使用, 立体声取左右平均
+        const size_t s = i * sample_channels;
+        const size_t r = s + sample_channels - 1;
+        int32_t mono;
+        if (sample_bits == 16) {
+            mono = (in16[s] + in16[r]) >> 1;
+        } else {
+            mono = ((in32[s] >> 16) + (in32[r] >> 16)) >> 1;
+        }
+#if !CONFIG_SPECTRUM_STYLE_AMBIENT
+        ring[ring_pos] = mono;
+        ring_pos = (ring_pos + 1) & (SPECTRUM_FFT_SIZE - 1);
+#endif
+        if (mono < 0) {
+            mono = -mono;
+        }
+        if (mono > peak) {
+            peak = mono;
+        }
+    }
+    portEXIT_CRITICAL(&ring_lock);
+    if (peak >= gate_amplitude) {
+        last_loud_ms = esp_timer_get_time() / 1000;
+        loud_seen = true;
+    }
+    int64_t cost = esp_timer_get_time() - start;
+    portENTER_CRITICAL(&ring_lock);
+    feed_total_us += cost;
+    feed_frames += frames;
+    portEXIT_CRITICAL(&ring_lock);
+}
+
+bool spectrum_is_active(void) {
+    return loud_seen && (uint32_t)(esp_timer_get_time() / 1000) - last_loud_ms < CONFIG_SPECTRUM_HOLD_S * 1000;
+}
+
+// 电平映射到 0 ~ full, 从 CONFIG_SPECTRUM_FLOOR_DB 到 0 dBFS 对应全程
+static uint32_t spectrum_level(float db, uint32_t full) {
+    float height = (db - CONFIG_SPECTRUM_FLOOR_DB) / -CONFIG_SPECTRUM_FLOOR_DB;
+    return height <= 0.0f ? 0 : height >= 1.0f ? full : (uint32_t)(height * full);
+}
+
+#if CONFIG_SPECTRUM_STYLE_AMBIENT
+static void spectrum_analyse(void) {
+    float energy[AMBIENT_BANDS];
+    portENTER_CRITICAL(&ring_lock);
+    uint32_t samples = band_samples;
+    for (int b = 0; b < AMBIENT_BANDS; b++) {
+        energy[b] = band_energy[b];
+        band_energy[b] = 0.0f;
+    }
+    band_samples = 0;
+    portEXIT_CRITICAL(&ring_lock);
+
+    // 回落速度与频谱相同, 以整列的高度为全程
+    const uint32_t falloff = CONFIG_SPECTRUM_FALLOFF * LED_SPECTRUM_ONE / PIXEL_HIGHT / CONFIG_SPECTRUM_FPS;
+    for (int b = 0; b < AMBIENT_BANDS; b++) {
+        uint32_t level = 0;
+        if (samples) {
+            level = spectrum_level(10.0f * log10f(energy[b] / samples / FULL_SCALE_MEAN_SQUARE + 1e-12f), LED_SPECTRUM_ONE);
+        }
+        ambient_levels[b] = level + falloff >= ambient_levels[b] ? level : ambient_levels[b] - falloff;
+    }
+}
+#else
+static void spectrum_analyse(void) {
+    // 取最近 SPECTRUM_FFT_SIZE 个采样, 按时间顺序排列
+    portENTER_CRITICAL(&ring_lock);
+    uint32_t pos = ring_pos;
+    memcpy(sample_buf, ring + pos, (SPECTRUM_FFT_SIZE - pos) * sizeof(int16_t));
+    memcpy(sample_buf + SPECTRUM_FFT_SIZE - pos, ring, pos * sizeof(int16_t));
+    portEXIT_CRITICAL(&ring_lock);
+
+    dsp_window_q15(sample_buf, sample_buf, window, SPECTRUM_FFT_SIZE);
+    for (int i = 0; i < SPECTRUM_FFT_SIZE; i++) {
+        fft_buf[i].re = sample_buf[i];
+        fft_buf[i].im = 0;
+    }
+    dsp_fft_r4_q15(&fft_plan, fft_buf);
+    dsp_magnitude_sq_q15(power, fft_buf, SPECTRUM_FFT_SIZE / 2);
+
+    const uint32_t full = PIXEL_HIGHT * LED_SPECTRUM_ONE;
+    const uint32_t falloff = CONFIG_SPECTRUM_FALLOFF * LED_SPECTRUM_ONE / CONFIG_SPECTRUM_FPS;
+    const uint32_t hold_frames = CONFIG_SPECTRUM_PEAK_HOLD_MS * CONFIG_SPECTRUM_FPS / 1000;
+    for (int b = 0; b < SPECTRUM_BANDS; b++) {
+        uint64_t band_power = 0;
+        for (int k = band_start[b]; k < band_start[b + 1]; k++) {
+            band_power += power[k];
+        }
+        uint32_t level = spectrum_level(10.0f * log10f(band_power / FULL_SCALE_POWER + 1e-12f), full);
+
+        // 上升立即跟随, 下降按固定速度回落
+        levels[b] = level + falloff >= levels[b] ? level : levels[b] - falloff;
+        if (level >= peaks[b]) {
+            peaks[b] = level;
+            peak_age[b] = 0;
+        } else if (peak_age[b] < hold_frames) {
+            peak_age[b]++;
+        } else {
+            peaks[b] = peaks[b] > falloff ? peaks[b] - falloff : 0;
+        }
+    }
+}
+#endif
+
+void spectrum_render(void) {
+    int64_t start = esp_timer_get_time();
+    spectrum_analyse();
+    int64_t analysed = esp_timer_get_time();
+#if CONFIG_SPECTRUM_STYLE_AMBIENT
+    led_display_ambient(ambient_levels[AMBIENT_BASS], ambient_levels[AMBIENT_MID], ambient_levels[AMBIENT_TREBLE]);
+#else
+    led_display_spectrum(levels, peaks, SPECTRUM_BANDS);
+#endif
+    int64_t end = esp_timer_get_time();
+
+    uint32_t analysis_us = analysed - start;
+    uint32_t render_us = end - analysed;
+    spectrum_stats.frames++;
+    spectrum_stats.analysis_last_us = analysis_us;
+    if (analysis_us > spectrum_stats.analysis_max_us) {
+        spectrum_stats.analysis_max_us = analysis_us;
+    }
+    if (render_us > spectrum_stats.render_max_us) {
+        spectrum_stats.render_max_us = render_us;
+    }
+    if (analysis_us + render_us > FRAME_PERIOD_US) {
+        spectrum_stats.overruns++;
+    }
+    analysis_total_us += analysis_us;
+    render_total_us += render_us;
+    spectrum_stats.analysis_avg_us = analysis_total_us / spectrum_stats.frames;
+    spectrum_stats.render_avg_us = render_total_us / spectrum_stats.frames;
+    spectrum_stats.load_permille = (spectrum_stats.analysis_avg_us + spectrum_stats.render_avg_us) * 1000 / FRAME_PERIOD_US;
+}
+
+void spectrum_get_stats(spectrum_stats_t *stats) {
+    *stats = spectrum_stats;
+    // 音频任务的耗时按处理的音频时长折算
+    portENTER_CRITICAL(&ring_lock);
+    uint64_t total_us = feed_total_us;
+    uint64_t frames = feed_frames;
+    portEXIT_CRITICAL(&ring_lock);
+    uint64_t audio_us = audio_sample_rate ? frames * 1000000 / audio_sample_rate : 0;
+    stats->feed_load_permille = audio_us ? total_us * 1000 / audio_us : 0;
+}
@@ -0,0 +1,45 @@
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// FFT 长度 (4 的幂, 使用基 4 FFT) 和频带数, 每个频带对应面板的一列
+#define SPECTRUM_FFT_SIZE 1024
+#define SPECTRUM_BANDS    32
+
+/**
+ * @brief Spectrum analyser statistics
+ */
+typedef struct {
+    uint32_t frames;                /*!< Spectrum frames analysed and rendered */
+    uint32_t analysis_last_us;      /*!< Window, FFT and band mapping time of the last frame */
+    uint32_t analysis_avg_us;       /*!< Mean analysis time */
+    uint32_t analysis_max_us;       /*!< Longest analysis time */
+    uint32_t render_avg_us;         /*!< Mean time to draw and commit a frame */
+    uint32_t render_max_us;         /*!< Longest time to draw and commit a frame */
+    uint32_t load_permille;         /*!< Mean analysis plus render time as a share of the frame period, in 1/1000 of one core */
+    uint32_t overruns;              /*!< Frames whose analysis and render took longer than the frame period */
+    uint32_t feed_load_permille;    /*!< Time spent in spectrum_feed as a share of the audio it processed, in 1/1000 of one core */
+} spectrum_stats_t;
+
+// 预先计算窗函数、旋转因子和频带边界, 在启动音频数据流之前调用
+// channels 为 1 或 2, 与 bits_per_sample 一起描述 spectrum_feed 收到的交错采样
+esp_err_t spectrum_init(uint32_t sample_rate, uint8_t channels, uint8_t bits_per_sample);
+
+// aic3101_i2s 的处理回调, 输出保持静音
+// 频谱模式把输入混成单声道放入环形缓冲, 环境模式在这里对整块做带通滤波并累加各频带的能量
+void spectrum_feed(const void *in, void *out, size_t frames, void *user_ctx);
+
+// 最近 CONFIG_SPECTRUM_HOLD_S 秒内输入电平超过门限时返回 true, 此时显示频谱而不是时钟
+bool spectrum_is_active(void);
+
+// 在显示任务中每帧调用一次: 频谱模式取最近的 SPECTRUM_FFT_SIZE 个采样做 FFT
+// 环境模式读取上一帧以来的频带能量, 然后刷新面板
+void spectrum_render(void);
+
+void spectrum_get_stats(spectrum_stats_t *stats);
+
+#endif // SPECTRUM_H
@@ -0,0 +1,84 @@
+#include <time.h>
+#include <sys/time.h>
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "nvs.h"
+#include "time_checkpoint.h"
+
+static const char *TAG = "time_checkpoint";
+
+#define NVS_NAMESPACE       "clock"
+#define NVS_KEY_TIME        "checkpoint"
+#define CHECKPOINT_MAGIC    0x4B615058U
+
+// 检查点之后系统时间超前太多, 说明 RTC 定时器已经不可信
+#define CHECKPOINT_MAX_GAP_S (24 * 3600)
+
+typedef struct {
+    uint32_t magic;
+    int64_t time;
+    uint32_t check;
+} rtc_checkpoint_t;
+
+// RTC_DATA_ATTR 的变量在软件复位后会被重新初始化, RTC_NOINIT_ATTR 在除上电以外的复位中都保持不变
+static RTC_NOINIT_ATTR rtc_checkpoint_t rtc_checkpoint;
+
+static int64_t last_nvs_save;
+
+static uint32_t checkpoint_check(const rtc_checkpoint_t *cp) {
+    return cp->magic ^ (uint32_t)cp->time ^ (uint32_t)(cp->time >> 32) ^ 0xA5A5A5A5U;
+}
+
+static void time_checkpoint_set(int64_t t) {
+    struct timeval tv = { .tv_sec = t, .tv_usec = 0 };
+    settimeofday(&tv, NULL);
+}
+
+time_source_t time_checkpoint_restore(void) {
+    time_t now = time(NULL);
+    if (rtc_checkpoint.magic == CHECKPOINT_MAGIC && rtc_checkpoint.check == checkpoint_check(&rtc_checkpoint)) {
+        // 系统时间由 RTC 定时器维持, 软件复位、看门狗复位和深度睡眠之后仍然有效
+        if (now >= rtc_checkpoint.time && now - rtc_checkpoint.time < CHECKPOINT_MAX_GAP_S) {
+            ESP_LOGI(TAG, "System time kept through reset");
+            return TIME_SOURCE_RTC;
+        }
+        time_checkpoint_set(rtc_checkpoint.time);
+        ESP_LOGI(TAG, "Time restored from RTC memory");
+        return TIME_SOURCE_RTC_CHECKPOINT;
+    }
+
+    // 掉电之后只剩 NVS 中最后一次保存的时间, 显示的时间会落后于断电的时长
+    nvs_handle_t handle;
+    int64_t saved = 0;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        nvs_get_i64(handle, NVS_KEY_TIME, &saved);
+        nvs_close(handle);
+    }
+    if (saved > now) {
+        time_checkpoint_set(saved);
+        last_nvs_save = saved;
+        ESP_LOGI(TAG, "Time restored from NVS");
+        return TIME_SOURCE_NVS;
+    }
+    return TIME_SOURCE_NONE;
+}
+
+void time_checkpoint_save(bool synced) {
+    time_t now = time(NULL);
+    rtc_checkpoint.magic = CHECKPOINT_MAGIC;
+    rtc_checkpoint.time = now;
+    rtc_checkpoint.check = checkpoint_check(&rtc_checkpoint);
+
+    // 只保存对过时的时间, 限制写入频率以减少 flash 磨损
+    if (!synced || now - last_nvs_save < CONFIG_TIME_CHECKPOINT_NVS_INTERVAL_MIN * 60) {
+        return;
+    }
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    if (nvs_set_i64(handle, NVS_KEY_TIME, now) == ESP_OK && nvs_commit(handle) == ESP_OK) {
+        last_nvs_save = now;
+    }
+    nvs_close(handle);
+}
@@ -0,0 +1,23 @@
+#ifndef TIME_CHECKPOINT_H
+#define TIME_CHECKPOINT_H
+
+#include <stdbool.h>
+#include "esp_err.h"
+
+/**
+ * @brief Where the time shown right after boot came from
+ */
+typedef enum {
+    TIME_SOURCE_NONE,           /*!< Nothing retained, the clock starts from the epoch */
+    TIME_SOURCE_RTC,            /*!< System time kept running through the reset, confirmed by the RTC memory checkpoint */
+    TIME_SOURCE_RTC_CHECKPOINT, /*!< System time was lost, restored from the RTC memory checkpoint */
+    TIME_SOURCE_NVS,            /*!< Power was lost, restored from the NVS checkpoint, behind by the time the device was off */
+} time_source_t;
+
+// 启动时调用, 在网络对时之前尽快恢复系统时间, 需要在 nvs_flash_init 之后调用
+time_source_t time_checkpoint_restore(void);
+
+// 每秒调用一次: 总是更新 RTC 内存中的检查点, 对过时之后按间隔写入 NVS
+void time_checkpoint_save(bool synced);
+
+#endif // TIME_CHECKPOINT_H
@@ -0,0 +1,182 @@
+#include <stdbool.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_event.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_wifi.h"
+#include "nvs.h"
+#include "wifi_conn.h"
+
+static const char *TAG = "wifi_conn";
+
+ESP_EVENT_DEFINE_BASE(WIFI_CONN_EVENT);
+
+#define NVS_NAMESPACE "wifi_conn"
+#define NVS_KEY_AP    "ap"
+// 事件队列满时稍后再投递一次
+#define RETRY_POST_DELAY_MS 100
+
+// 上次成功连接的 AP, 与当前配置的 SSID 相同时直接连接, 不需要扫描全部信道
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t bssid[6];
+    uint8_t channel;
+} wifi_ap_cache_t;
+
+static wifi_ap_cache_t ap_cache;
+static bool cache_valid;
+static bool fast_attempt;           // 本次尝试使用了缓存的 AP
+static bool connected;              // 已获得 IP
+static uint32_t failures_in_row;
+static int64_t attempt_start_us;    // 本次尝试的开始时间
+static int64_t outage_start_us;     // 断线后第一次尝试的开始时间
+static esp_timer_handle_t retry_timer;
+static wifi_conn_stats_t conn_stats;
+
+static void wifi_conn_connect(void) {
+    wifi_config_t cfg;
+    if (esp_wifi_get_config(WIFI_IF_STA, &cfg) == ESP_OK) {
+        fast_attempt = false;
+#ifdef CONFIG_WIFI_FAST_RECONNECT
+        fast_attempt = cache_valid && memcmp(cfg.sta.ssid, ap_cache.ssid, sizeof(ap_cache.ssid)) == 0;
+#endif
+        uint8_t channel = fast_attempt ? ap_cache.channel : 0;
+        // 较长的监听间隔让射频在 modem sleep 中睡得更久, 需要在连接之前设置
+        bool changed = cfg.sta.bssid_set != fast_attempt || cfg.sta.channel != channel
+                       || cfg.sta.listen_interval != CONFIG_POWER_MGR_LISTEN_INTERVAL
+                       || (fast_attempt && memcmp(cfg.sta.bssid, ap_cache.bssid, sizeof(ap_cache.bssid)) != 0);
+        // 配置没有变化时不调用 esp_wifi_set_config, 避免每次重连都写 flash
+        if (changed) {
+            cfg.sta.bssid_set = fast_attempt;
+            cfg.sta.channel = channel;
+            cfg.sta.listen_interval = CONFIG_POWER_MGR_LISTEN_INTERVAL;
+            if (fast_attempt) {
+                memcpy(cfg.sta.bssid, ap_cache.bssid, sizeof(ap_cache.bssid));
+            }
+            esp_wifi_set_config(WIFI_IF_STA, &cfg);
+        }
+    }
+    attempt_start_us = esp_timer_get_time();
+    conn_stats.attempts++;
+    if (fast_attempt) {
+        conn_stats.fast_attempts++;
+    }
+    esp_wifi_connect();
+}
+
+// 定时器回调运行在 esp_timer 任务中, 只把重连投递到默认事件循环
+// 连接状态只在事件循环中访问, 不会与 Wi-Fi 事件的处理并发
+static void wifi_conn_retry_cb(void *arg) {
+    if (esp_event_post(WIFI_CONN_EVENT, WIFI_CONN_EVENT_RETRY, NULL, 0, 0) != ESP_OK) {
+        esp_timer_start_once(retry_timer, RETRY_POST_DELAY_MS * 1000);
+    }
+}
+
+static void wifi_conn_retry_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
+    // 投递之后可能已经连上, 或者断线事件已经安排了新的重连
+    if (connected || esp_timer_is_active(retry_timer)) {
+        return;
+    }
+    wifi_conn_connect();
+}
+
+static void wifi_conn_save_ap(void) {
+    wifi_config_t cfg;
+    wifi_ap_record_t ap;
+    if (esp_wifi_get_config(WIFI_IF_STA, &cfg) != ESP_OK || esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        return;
+    }
+    wifi_ap_cache_t current = { .channel = ap.primary };
+    memcpy(current.ssid, cfg.sta.ssid, sizeof(current.ssid));
+    memcpy(current.bssid, ap.bssid, sizeof(current.bssid));
+    if (cache_valid && memcmp(&current, &ap_cache, sizeof(current)) == 0) {
+        return;
+    }
+    ap_cache = current;
+    cache_valid = true;
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK) {
+        if (nvs_set_blob(handle, NVS_KEY_AP, &ap_cache, sizeof(ap_cache)) == ESP_OK) {
+            nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    ESP_LOGI(TAG, "Cached AP " MACSTR " on channel %d", MAC2STR(ap_cache.bssid), ap_cache.channel);
+}
+
+esp_err_t wifi_conn_init(void) {
+    ESP_RETURN_ON_FALSE(retry_timer == NULL, ESP_ERR_INVALID_STATE, TAG, "already initialized");
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        size_t len = sizeof(ap_cache);
+        cache_valid = nvs_get_blob(handle, NVS_KEY_AP, &ap_cache, &len) == ESP_OK && len == sizeof(ap_cache);
+        nvs_close(handle);
+    }
+    const esp_timer_create_args_t timer_args = {
+        .callback = wifi_conn_retry_cb,
+        .name = "wifi_retry",
+    };
+    ESP_RETURN_ON_ERROR(esp_timer_create(&timer_args, &retry_timer), TAG, "create timer failed");
+    return esp_event_handler_register(WIFI_CONN_EVENT, WIFI_CONN_EVENT_RETRY, wifi_conn_retry_handler, NULL);
+}
+
+void wifi_conn_on_start(void) {
+    outage_start_us = esp_timer_get_time();
+    wifi_conn_connect();
+}
+
+void wifi_conn_on_connected(void) {
+    conn_stats.last_connect_ms = (esp_timer_get_time() - attempt_start_us) / 1000;
+    wifi_conn_save_ap();
+}
+
+void wifi_conn_on_disconnected(uint8_t reason) {
+    if (connected) {
+        // 连接中断, 立即重连一次
+        connected = false;
+        outage_start_us = esp_timer_get_time();
+        ESP_LOGI(TAG, "Disconnected (reason %d), reconnecting", reason);
+        wifi_conn_connect();
+        return;
+    }
+    conn_stats.failures++;
+    if (fast_attempt) {
+        // AP 可能换了信道或者换了一台, 不再使用缓存, 立即扫描全部信道重试
+        cache_valid = false;
+        ESP_LOGI(TAG, "Fast reconnect failed (reason %d), scanning", reason);
+        wifi_conn_connect();
+        return;
+    }
+
+    // 指数退避, 随机取后一半, 多台设备不会在 AP 恢复时同时重连
+    uint32_t shift = failures_in_row < 16 ? failures_in_row : 16;
+    uint64_t delay_ms = (uint64_t)CONFIG_WIFI_RETRY_BASE_MS << shift;
+    if (delay_ms > CONFIG_WIFI_RETRY_MAX_MS) {
+        delay_ms = CONFIG_WIFI_RETRY_MAX_MS;
+    }
+    delay_ms = delay_ms / 2 + esp_random() % (delay_ms / 2 + 1);
+    failures_in_row++;
+    conn_stats.backoff_ms = delay_ms;
+    ESP_LOGI(TAG, "Connect failed (reason %d), retry %lu in %lu ms", reason, failures_in_row, conn_stats.backoff_ms);
+    esp_timer_stop(retry_timer);
+    esp_timer_start_once(retry_timer, delay_ms * 1000);
+}
+
+void wifi_conn_on_got_ip(void) {
+    int64_t now = esp_timer_get_time();
+    conn_stats.last_ip_ms = (now - outage_start_us) / 1000;
+    if (conn_stats.boot_to_ip_ms == 0) {
+        conn_stats.boot_to_ip_ms = now / 1000;
+    }
+    connected = true;
+    failures_in_row = 0;
+    conn_stats.backoff_ms = 0;
+    ESP_LOGI(TAG, "Got IP %lu ms after the first attempt, %lu ms after boot (%s)", conn_stats.last_ip_ms,
+             conn_stats.boot_to_ip_ms, fast_attempt ? "cached AP" : "scan");
+}
+
+void wifi_conn_get_stats(wifi_conn_stats_t *stats) {
+    *stats = conn_stats;
+}
@@ -0,0 +1,40 @@
+#ifndef WIFI_CONN_H
+#define WIFI_CONN_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_event.h"
+
+ESP_EVENT_DECLARE_BASE(WIFI_CONN_EVENT);
+
+// 重连定时器到期, 在默认事件循环中发起下一次尝试
+enum {
+    WIFI_CONN_EVENT_RETRY,
+};
+
+/**
+ * @brief Wi-Fi connection statistics
+ */
+typedef struct {
+    uint32_t attempts;          /*!< Calls to esp_wifi_connect */
+    uint32_t fast_attempts;     /*!< Attempts that used the cached BSSID and channel instead of a full scan */
+    uint32_t failures;          /*!< Disconnect events received before getting an IP */
+    uint32_t backoff_ms;        /*!< Delay before the next attempt, 0 while connected */
+    uint32_t last_connect_ms;   /*!< Time from the last successful attempt to association */
+    uint32_t last_ip_ms;        /*!< Time from the first attempt after a disconnect to getting an IP */
+    uint32_t boot_to_ip_ms;     /*!< Time from boot to the first IP */
+} wifi_conn_stats_t;
+
+// 在 esp_wifi_init 之后调用: 从 NVS 读取上次连接的 AP, 创建重连定时器
+// 需要默认事件循环, 重连在其中发起
+esp_err_t wifi_conn_init(void);
+
+// 以下函数在默认事件循环的 Wi-Fi 事件回调中调用, 与重连在同一个任务中, 不需要加锁
+void wifi_conn_on_start(void);
+void wifi_conn_on_connected(void);
+void wifi_conn_on_disconnected(uint8_t reason);
+void wifi_conn_on_got_ip(void);
+
+void wifi_conn_get_stats(wifi_conn_stats_t *stats);
+
+#endif // WIFI_CONN_H
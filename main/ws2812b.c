@@ -1,17 +1,242 @@
+#include <inttypes.h>
+#include <math.h>
 #include <stdio.h>
+#include <string.h>
+#include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "led_strip.h"
 #include "esp_log.h"
 #include "esp_err.h"
+#include "esp_check.h"
 #include "ws2812b.h"
+#include "led_matrix.h"
+#include "font.h"
+#include "led_profile.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include "led_strip_sim.h"
+#elif CONFIG_LED_PROFILE
+#include "esp_attr.h"
+#include "esp_timer.h"
+#endif
 
 static const char *TAG = "WS2812B";
 
 static led_strip_handle_t led_strip_handle;
 
+#if CONFIG_LED_PROFILE
+// 最近一次提交的帧的刷新开始和发送完成时间, 异步刷新的完成时间由发送完成中断写入
+static int64_t refresh_start_ns;
+static volatile int64_t refresh_done_ns;
+
+#if !CONFIG_IDF_TARGET_LINUX
+static bool IRAM_ATTR led_refresh_done(led_strip_handle_t strip, void *user_ctx)
+{
+    if (refresh_done_ns == 0) {
+        refresh_done_ns = esp_timer_get_time() * 1000;
+    }
+    return false;
+}
+#endif
+#endif
+
+_Static_assert(PIXEL_WIDTH <= 32, "1 bpp rows are stored in one 32-bit word");
+
+// 离屏帧缓冲, 同一时间只使用与当前格式对应的一个, 保存未经 gamma 和亮度换算的颜色
+static led_fb_format_t fb_format = LED_FB_FORMAT_RGB888;
+static uint8_t framebuffer[PIXEL_HIGHT][PIXEL_WIDTH][3];    // RGB888, 按行存储
+static uint8_t index_framebuffer[PIXEL_HIGHT][PIXEL_WIDTH]; // 调色板下标
+static uint32_t mono_framebuffer[PIXEL_HIGHT];              // 每行一个字, 最高位为最左列
+
+// 调色板, 下标和单色帧的 0/1 都在这里取颜色
+static uint8_t palette[256][3];
+static bool palette_dirty = true;
+
+// 最近一次提交的帧, 亮度变化和时间抖动时从这里重新输出
+static led_fb_format_t committed_format = LED_FB_FORMAT_RGB888;
+static uint8_t committed_framebuffer[PIXEL_HIGHT][PIXEL_WIDTH][3];
+static uint8_t committed_index_framebuffer[PIXEL_HIGHT][PIXEL_WIDTH];
+static uint32_t committed_mono_framebuffer[PIXEL_HIGHT];
+
+// 按灯带顺序排列、已经过 gamma 和亮度换算的 RGB, 供 led_strip_set_pixels 一次写入
+static uint8_t strip_pixels[LED_STRIP_LED_NUMBERS][3];
+
+// 最近一次发送到灯带的内容, 用于跳过内容未变化的刷新
+static uint8_t sent_strip_pixels[LED_STRIP_LED_NUMBERS][3];
+static bool sent_strip_valid = false;
+
+// gamma 和亮度查找表, 8.8 定点数, 高 8 位为输出值, 低 8 位为小数部分
+static uint16_t color_lut[256];
+static uint8_t brightness = CONFIG_LED_BRIGHTNESS;
+
+// 已经过查找表换算的调色板, 调色板或亮度变化时重建
+static uint16_t palette_lut[256][3];
+
+#if CONFIG_LED_DITHER
+// 每个灯珠每个通道累积的小数部分, 攒满 1 时该帧输出值加 1
+static uint8_t dither_error[LED_STRIP_LED_NUMBERS][3];
+#endif
+
+// 保护提交帧、灯带缓冲、查找表和统计, 绘制任务和抖动任务都会输出帧
+static SemaphoreHandle_t frame_lock;
+
+static led_frame_stats_t frame_stats;
+// 上一帧提交之后发出的刷新 (清屏、亮度变化), 计入下一个提交帧, 抖动刷新不计入
+static uint32_t frame_refreshes;
+
+static void led_color_lut_build(uint8_t percent) {
+    const float gamma = CONFIG_LED_GAMMA_X10 / 10.0f;
+    const float full_scale = 255.0f * 256.0f * percent / 100.0f;
+    for (int v = 0; v < 256; v++) {
+        color_lut[v] = (uint16_t)lroundf(powf(v / 255.0f, gamma) * full_scale);
+    }
+}
+
+static void led_palette_lut_build() {
+    for (int i = 0; i < 256; i++) {
+        palette_lut[i][0] = color_lut[palette[i][0]];
+        palette_lut[i][1] = color_lut[palette[i][1]];
+        palette_lut[i][2] = color_lut[palette[i][2]];
+    }
+}
+
+static void led_frame_invalidate() {
+    sent_strip_valid = false;
+}
+
+// 把一个像素换算后的 8.8 颜色写入灯带顺序的缓冲
+static inline void led_pixel_output(uint16_t led, const uint16_t value[3]) {
+    uint8_t *out = strip_pixels[led];
+#if CONFIG_LED_DITHER
+    uint8_t *error = dither_error[led];
+    for (int c = 0; c < 3; c++) {
+        uint32_t acc = value[c] + error[c];
+        error[c] = acc & 0xFF;
+        out[c] = acc >> 8;
+    }
+#else
+    out[0] = (value[0] + 0x80) >> 8;
+    out[1] = (value[1] + 0x80) >> 8;
+    out[2] = (value[2] + 0x80) >> 8;
+#endif
+}
+
+// 对提交帧做一次查表, 同时完成 gamma、亮度换算和灯带顺序整理, 内容有变化时刷新灯带
+// 调用前需持有 frame_lock, profile 为 true 时记录各阶段耗时
+static esp_err_t led_frame_output(bool profile, bool *refreshed) {
+    *refreshed = false;
+#if CONFIG_LED_PROFILE
+    int64_t start = profile ? led_profile_now_ns() : 0;
+#endif
+    switch (committed_format) {
+    case LED_FB_FORMAT_RGB888: {
+        const uint8_t *rgb = &committed_framebuffer[0][0][0];
+        for (int i = 0; i < LED_STRIP_LED_NUMBERS; i++) {
+            const uint16_t value[3] = {color_lut[rgb[0]], color_lut[rgb[1]], color_lut[rgb[2]]};
+            led_pixel_output(led_matrix_map[i], value);
+            rgb += 3;
+        }
+        break;
+    }
+    case LED_FB_FORMAT_INDEXED8: {
+        // 调色板已经换算过, 每个像素只查一次表
+        const uint8_t *index = &committed_index_framebuffer[0][0];
+        for (int i = 0; i < LED_STRIP_LED_NUMBERS; i++) {
+            led_pixel_output(led_matrix_map[i], palette_lut[index[i]]);
+        }
+        break;
+    }
+    case LED_FB_FORMAT_MONO1: {
+        const uint16_t *map = led_matrix_map;
+        for (int y = 0; y < PIXEL_HIGHT; y++) {
+            uint32_t row = committed_mono_framebuffer[y];
+            for (int x = 0; x < PIXEL_WIDTH; x++) {
+                led_pixel_output(*map++, palette_lut[row >> 31]);
+                row <<= 1;
+            }
+        }
+        break;
+    }
+    }
+#if CONFIG_LED_PROFILE
+    if (profile) {
+        led_profile_add(LED_PROFILE_SCALE, led_profile_now_ns() - start);
+    }
+#endif
+
+    // 换算之后再比较, 亮度变化或抖动进位都会触发刷新
+    if (sent_strip_valid && memcmp(strip_pixels, sent_strip_pixels, sizeof(strip_pixels)) == 0) {
+        return ESP_OK;
+    }
+
+#if CONFIG_LED_PROFILE
+    start = profile ? led_profile_now_ns() : 0;
+#endif
+    ESP_RETURN_ON_ERROR(led_strip_set_pixels(led_strip_handle, 0, &strip_pixels[0][0], LED_STRIP_LED_NUMBERS), TAG, "set pixels failed");
+#if CONFIG_LED_PROFILE
+    if (profile) {
+        led_profile_add(LED_PROFILE_CONVERT, led_profile_now_ns() - start);
+        // 等待抖动刷新的帧发完, 发送完成时间只对应这一次刷新
+        led_strip_wait_refresh_done(led_strip_handle, -1);
+        refresh_done_ns = 0;
+        refresh_start_ns = led_profile_now_ns();
+    }
+#endif
+
+    // 异步刷新, 传输期间可以继续在帧缓冲中绘制下一帧
+    esp_err_t err = led_strip_refresh_async(led_strip_handle);
+    if (err != ESP_OK) {
+        led_frame_invalidate();
+        ESP_LOGE(TAG, "refresh failed: %s", esp_err_to_name(err));
+        return err;
+    }
+#if CONFIG_LED_PROFILE
+    if (profile) {
+#if CONFIG_IDF_TARGET_LINUX
+        // 模拟灯带同步刷新, 返回时已经"发送"完成
+        refresh_done_ns = led_profile_now_ns();
+#else
+        led_strip_rmt_encoder_stats_t encoder_stats;
+        if (led_strip_rmt_get_encoder_stats(led_strip_handle, &encoder_stats) == ESP_OK) {
+            led_profile_add(LED_PROFILE_ENCODE, (int64_t)encoder_stats.last_encode_cycles * 1000 / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+        }
+#endif
+    }
+#endif
+    frame_stats.refreshes++;
+    memcpy(sent_strip_pixels, strip_pixels, sizeof(strip_pixels));
+    sent_strip_valid = true;
+    *refreshed = true;
+    return ESP_OK;
+}
+
+#if CONFIG_LED_DITHER
+// 以固定帧率重复输出最近提交的帧, 小数部分在相邻帧之间累积, 低亮度下得到超过 8 位的灰度
+static void led_dither_task(void *pvParameters) {
+    TickType_t last_wake = xTaskGetTickCount();
+    while (1) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(1000 / CONFIG_LED_DITHER_FPS));
+        bool refreshed;
+        xSemaphoreTake(frame_lock, portMAX_DELAY);
+        if (led_frame_output(false, &refreshed) == ESP_OK && refreshed) {
+            frame_stats.dither_refreshes++;
+        }
+        xSemaphoreGive(frame_lock);
+    }
+}
+#endif
+
 esp_err_t led_init()
 {
+    frame_lock = xSemaphoreCreateMutex();
+    if (frame_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    led_color_lut_build(brightness);
+    led_palette_lut_build();
+    palette_dirty = false;
+
     // LED strip general initialization, according to your led board design
     led_strip_config_t strip_config = {
         .strip_gpio_num = LED_STRIP_BLINK_GPIO,   // The GPIO that connected to the LED strip's data line
@@ -20,6 +245,22 @@ esp_err_t led_init()
         .led_model = LED_MODEL_WS2812,            // LED strip model
         .flags.invert_out = false,                // whether to invert the output signal
     };
+#if CONFIG_IDF_TARGET_LINUX
+    // 主机仿真: 用模拟灯带代替 RMT, 帧内容录制到文件或绘制在终端
+    led_strip_sim_config_t sim_config = {
+        .record_path = CONFIG_LED_SIM_RECORD_PATH[0] ? CONFIG_LED_SIM_RECORD_PATH : NULL,
+        .ppm_dir = CONFIG_LED_SIM_PPM_DIR[0] ? CONFIG_LED_SIM_PPM_DIR : NULL,
+#if CONFIG_LED_SIM_ANSI_OUTPUT
+        .ansi_output = true,
+#endif
+    };
+    esp_err_t err = led_strip_new_sim_device(&strip_config, &sim_config, &led_strip_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Simulated strip initialize failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    ESP_LOGI(TAG, "Created LED strip object with simulated backend");
+#else
     // LED strip backend configuration: RMT
     led_strip_rmt_config_t rmt_config = {
 #if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 0, 0)
@@ -28,6 +269,11 @@ esp_err_t led_init()
         .clk_src = RMT_CLK_SRC_DEFAULT,        // different clock source can lead to different power consumption
         .resolution_hz = LED_STRIP_RMT_RES_HZ, // RMT counter clock frequency
         .flags.with_dma = true,               // DMA feature is available on ESP target like ESP32-S3
+        .flags.double_buffer = true,          // draw the next frame while the current one is still on the wire
+        .flags.with_symbol_cache = true,      // keep the frame pre-encoded, only changed bytes are re-encoded
+#if CONFIG_LED_PROFILE
+        .on_refresh_done = led_refresh_done,  // timestamp the end of every frame on the wire
+#endif
 #endif
     };
 
@@ -38,109 +284,372 @@ esp_err_t led_init()
         return err;
     }
     ESP_LOGI(TAG, "Created LED strip object with RMT backend");
+#endif
 
     ESP_ERROR_CHECK(led_strip_clear(led_strip_handle)); // Clear all the LEDs
+#if CONFIG_LED_DITHER
+    if (xTaskCreate(led_dither_task, "led_dither", 3072, NULL, 6, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create dither task");
+        return ESP_ERR_NO_MEM;
+    }
+#endif
     return ESP_OK;
     
 }
 
+void led_fb_set_format(led_fb_format_t format) {
+    fb_format = format;
+}
+
+led_fb_format_t led_fb_get_format() {
+    return fb_format;
+}
+
+void led_fb_clear() {
+    switch (fb_format) {
+    case LED_FB_FORMAT_RGB888:
+        memset(framebuffer, 0, sizeof(framebuffer));
+        break;
+    case LED_FB_FORMAT_INDEXED8:
+        memset(index_framebuffer, 0, sizeof(index_framebuffer));
+        break;
+    case LED_FB_FORMAT_MONO1:
+        memset(mono_framebuffer, 0, sizeof(mono_framebuffer));
+        break;
+    }
+}
+
+void led_fb_set_palette(uint8_t index, uint8_t red, uint8_t green, uint8_t blue) {
+    if (palette[index][0] != red || palette[index][1] != green || palette[index][2] != blue) {
+        palette[index][0] = red;
+        palette[index][1] = green;
+        palette[index][2] = blue;
+        palette_dirty = true;
+    }
+}
+
+void led_fb_set_index(int x, int y, uint8_t index) {
+    if (x < 0 || x >= PIXEL_WIDTH || y < 0 || y >= PIXEL_HIGHT) {
+        return;
+    }
+    index_framebuffer[y][x] = index;
+}
+
+void led_fb_mono_set(int x, int y, bool on) {
+    if (x < 0 || x >= PIXEL_WIDTH || y < 0 || y >= PIXEL_HIGHT) {
+        return;
+    }
+    uint32_t bit = 0x80000000u >> x;
+    mono_framebuffer[y] = on ? (mono_framebuffer[y] | bit) : (mono_framebuffer[y] & ~bit);
+}
+
+uint32_t *led_fb_mono_rows() {
+    return mono_framebuffer;
+}
+
+void led_fb_mono_scroll(int dx) {
+    for (int y = 0; y < PIXEL_HIGHT; y++) {
+        if (dx >= 32 || dx <= -32) {
+            mono_framebuffer[y] = 0;
+        } else if (dx > 0) {
+            mono_framebuffer[y] <<= dx;
+        } else {
+            mono_framebuffer[y] >>= -dx;
+        }
+    }
+}
+
 esp_err_t led_clear_all() {
-    return led_strip_clear(led_strip_handle);
-}
-
-const uint8_t font_num[10][3] = {
-    {0x3E, 0x44, 0x3E}, // 0
-    {0x12, 0x7C, 0x02}, // 1
-    {0x26, 0x54, 0x32}, // 2
-    {0x2A, 0x54, 0x3E}, // 3
-    {0x38, 0x10, 0x3E}, // 4
-    {0x3A, 0x54, 0x2E}, // 5
-    {0x3E, 0x54, 0x2E}, // 6
-    {0x20, 0x74, 0x30}, // 7
-    {0x3E, 0x54, 0x3E}, // 8
-    {0x3A, 0x54, 0x3E}  // 9
-};
-
-const uint8_t font_space[1][1] = {
-    {0x00}
-};
-
-const uint8_t font_colon[1][1] = {
-    {0x14}
-};
-
-bool led_is_reverse(int start_index) {
-    return (start_index/8%2) != 0;
-}
-
-void led_set_num_pixel(int num,int *start_index, uint32_t red, uint32_t green, uint32_t blue, uint8_t brightness, bool reverse) {
-    int end_index = *start_index;
-    for (int i = 0; i < sizeof(font_num[0]) / sizeof(font_num[0][0]) ; i++) {
-        for (int j = 0; j < 8; j++) {
-            int bit_pos = reverse ? j : (7 - j);  // 根据 reverse 计算当前位位置
-            int re = (font_num[num][i] >> bit_pos) & 1;
-            if (re == 1) {
-                ESP_ERROR_CHECK(led_strip_set_pixel(led_strip_handle, end_index, red*brightness/100, green*brightness/100, blue*brightness/100));
-            }else {
-                ESP_ERROR_CHECK(led_strip_set_pixel(led_strip_handle, end_index, 0, 0, 0));
-            }
-            end_index +=1;
+    led_fb_clear();
+    xSemaphoreTake(frame_lock, portMAX_DELAY);
+    memset(committed_framebuffer, 0, sizeof(committed_framebuffer));
+    memset(committed_index_framebuffer, 0, sizeof(committed_index_framebuffer));
+    memset(committed_mono_framebuffer, 0, sizeof(committed_mono_framebuffer));
+    led_frame_invalidate();
+    esp_err_t err = led_strip_clear(led_strip_handle);
+    if (err == ESP_OK) {
+        frame_stats.refreshes++;
+        frame_refreshes++;
+    }
+    xSemaphoreGive(frame_lock);
+    return err;
+}
+
+void led_fb_set_pixel(int x, int y, uint8_t red, uint8_t green, uint8_t blue) {
+    if (x < 0 || x >= PIXEL_WIDTH || y < 0 || y >= PIXEL_HIGHT) {
+        return;
+    }
+    framebuffer[y][x][0] = red;
+    framebuffer[y][x][1] = green;
+    framebuffer[y][x][2] = blue;
+}
+
+esp_err_t led_frame_commit() {
+    xSemaphoreTake(frame_lock, portMAX_DELAY);
+    frame_stats.frames++;
+#if CONFIG_LED_PROFILE
+    // 上一次刷新此时已经发送完成, 发送耗时计入当前帧
+    if (refresh_start_ns && refresh_done_ns >= refresh_start_ns) {
+        led_profile_add(LED_PROFILE_TRANSMIT, refresh_done_ns - refresh_start_ns);
+        refresh_start_ns = 0;
+    }
+#endif
+    // 只复制当前格式的缓冲, 单色帧只有 32 字节
+    committed_format = fb_format;
+    switch (fb_format) {
+    case LED_FB_FORMAT_RGB888:
+        memcpy(committed_framebuffer, framebuffer, sizeof(framebuffer));
+        break;
+    case LED_FB_FORMAT_INDEXED8:
+        memcpy(committed_index_framebuffer, index_framebuffer, sizeof(index_framebuffer));
+        break;
+    case LED_FB_FORMAT_MONO1:
+        memcpy(committed_mono_framebuffer, mono_framebuffer, sizeof(mono_framebuffer));
+        break;
+    }
+    if (palette_dirty) {
+        led_palette_lut_build();
+        palette_dirty = false;
+    }
+
+    bool refreshed;
+    esp_err_t err = led_frame_output(true, &refreshed);
+    if (err == ESP_OK) {
+        if (refreshed) {
+            frame_stats.transmitted++;
+            frame_refreshes++;
+        } else {
+            frame_stats.skipped++;
         }
     }
-    ESP_ERROR_CHECK(led_strip_refresh(led_strip_handle));
-    *start_index = end_index;
+    frame_stats.last_frame_refreshes = frame_refreshes;
+    frame_refreshes = 0;
+    xSemaphoreGive(frame_lock);
+    return err;
 }
 
-void led_set_colon(int *start_index, uint32_t red, uint32_t green, uint32_t blue, uint8_t brightness, bool reverse) {
-    int end_index = *start_index;
-        for (int j = 0; j < 8; j++) {
-            int bit_pos = reverse ? j : (7 - j);  // 根据 reverse 计算当前位位置
-            int re = (font_colon[0][j] >> bit_pos) & 1;
-            if (re == 1) {
-                ESP_ERROR_CHECK(led_strip_set_pixel(led_strip_handle, end_index, red*brightness/100, green*brightness/100, blue*brightness/100));
-            }else {
-                ESP_ERROR_CHECK(led_strip_set_pixel(led_strip_handle, end_index, 0, 0, 0));
-            }
-            end_index +=1;
+esp_err_t led_set_brightness(uint8_t percent) {
+    if (percent > 100) {
+        percent = 100;
+    }
+    xSemaphoreTake(frame_lock, portMAX_DELAY);
+    esp_err_t err = ESP_OK;
+    if (percent != brightness) {
+        brightness = percent;
+        led_color_lut_build(brightness);
+        led_palette_lut_build();
+        // 立即按新的亮度重新输出当前帧
+        bool refreshed;
+        err = led_frame_output(false, &refreshed);
+        if (err == ESP_OK && refreshed) {
+            frame_refreshes++;
+        }
+    }
+    xSemaphoreGive(frame_lock);
+    return err;
+}
+
+uint8_t led_get_brightness() {
+    return brightness;
+}
+
+void led_get_frame_stats(led_frame_stats_t *stats) {
+    xSemaphoreTake(frame_lock, portMAX_DELAY);
+    *stats = frame_stats;
+    xSemaphoreGive(frame_lock);
+#if !CONFIG_IDF_TARGET_LINUX
+    led_strip_rmt_encoder_stats_t encoder_stats = {0};
+    if (led_strip_handle && led_strip_rmt_get_encoder_stats(led_strip_handle, &encoder_stats) == ESP_OK) {
+        stats->last_encode_cycles = encoder_stats.last_encode_cycles;
+        stats->last_bytes_encoded = encoder_stats.last_bytes_encoded;
+    }
+#endif
+}
+
+// 按列绘制字模, 字节的最高位对应最上面一行
+static void led_draw_column(int x, uint8_t bits, uint8_t red, uint8_t green, uint8_t blue) {
+    for (int y = 0; y < PIXEL_HIGHT; y++) {
+        int on = (bits >> (7 - y)) & 1;
+        if (fb_format == LED_FB_FORMAT_RGB888) {
+            led_fb_set_pixel(x, y, on ? red : 0, on ? green : 0, on ? blue : 0);
+        } else {
+            led_fb_set_index(x, y, on);
         }
-    ESP_ERROR_CHECK(led_strip_refresh(led_strip_handle));
-    *start_index = end_index;
+    }
 }
 
-void led_set_space(int *start_index) {
-    *start_index += 8;
+// 单色格式按行整字写入: 先把按列存储的字模转置成每行一个位图, 再与帧缓冲做一次掩码合并
+static void led_draw_glyph_mono(int x, const uint8_t *columns, int width) {
+    uint32_t rows[8] = {0};
+    for (int i = 0; i < width; i++) {
+        for (int y = 0; y < 8; y++) {
+            rows[y] = (rows[y] << 1) | ((columns[i] >> (7 - y)) & 1);
+        }
+    }
+    // 字模最右一列落在第 x + width - 1 列, 用 64 位移位处理部分超出左右边界的情况
+    int shift = 64 - x - width;
+    if (shift < 0 || shift >= 64) {
+        return;
+    }
+    uint64_t mask = (((uint64_t)1 << width) - 1) << shift;
+    for (int y = 0; y < PIXEL_HIGHT && y < 8; y++) {
+        uint64_t row = (uint64_t)mono_framebuffer[y] << 32;
+        row = (row & ~mask) | (((uint64_t)rows[y] << shift) & mask);
+        mono_framebuffer[y] = row >> 32;
+    }
 }
 
-void led_display_time(const struct tm *timeinfo) {
-    // ESP_ERROR_CHECK(led_clear_all());
+int led_draw_glyph(int x, uint32_t codepoint, uint8_t red, uint8_t green, uint8_t blue) {
+    LED_PROFILE_BEGIN(lookup);
+    const font_glyph_t *glyph = font_find_glyph(codepoint);
+    LED_PROFILE_END(LED_PROFILE_GLYPH_LOOKUP, lookup);
+    if (glyph == NULL) {
+        ESP_LOGD(TAG, "No glyph for U+%04" PRIX32, codepoint);
+        return x;
+    }
 
-    int hour1 = timeinfo->tm_hour / 10;  // 小时的十位
-    int hour2 = timeinfo->tm_hour % 10;  // 小时的个位
-    int minute1 = timeinfo->tm_min / 10;  // 分钟的十位
-    int minute2 = timeinfo->tm_min % 10;  // 分钟的个位
-    int second1 = timeinfo->tm_sec / 10;  // 秒的十位
-    int second2 = timeinfo->tm_sec % 10;  // 秒的个位
+    LED_PROFILE_BEGIN(compose);
+    const uint8_t *columns = font_glyph_columns(glyph);
+    if (fb_format == LED_FB_FORMAT_MONO1) {
+        // 行位图为 32 位, 更宽的字模每 32 列写一次
+        for (int i = 0; i < glyph->width; i += 32) {
+            led_draw_glyph_mono(x + i, columns + i, glyph->width - i < 32 ? glyph->width - i : 32);
+        }
+    } else {
+        for (int i = 0; i < glyph->width; i++) {
+            led_draw_column(x + i, columns[i], red, green, blue);
+        }
+    }
+    LED_PROFILE_END(LED_PROFILE_COMPOSE, compose);
+    return x + glyph->width + glyph->spacing;
+}
 
-    int index = 0;
-    led_set_space(&index);
-    led_set_space(&index);
-    led_set_num_pixel(hour1, &index, 255, 0, 0, 1, led_is_reverse(index));
-    led_set_space(&index);
-    led_set_num_pixel(hour2, &index, 255, 0, 0, 1, led_is_reverse(index));
-    led_set_space(&index);
-    led_set_colon(&index, 255, 0, 0, 1, led_is_reverse(index));
-    led_set_space(&index);
+// 解码一个 UTF-8 字符, 返回下一个字符的位置
+static const char *led_utf8_next(const char *text, uint32_t *codepoint) {
+    const uint8_t *p = (const uint8_t *)text;
+    if (p[0] < 0x80) {
+        *codepoint = p[0];
+        return text + 1;
+    }
+    int extra = (p[0] >= 0xF0) ? 3 : (p[0] >= 0xE0) ? 2 : 1;
+    uint32_t cp = p[0] & (0x3F >> extra);
+    for (int i = 1; i <= extra; i++) {
+        if ((p[i] & 0xC0) != 0x80) {
+            *codepoint = 0xFFFD;  // 非法编码
+            return text + i;
+        }
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+    *codepoint = cp;
+    return text + extra + 1;
+}
+
+int led_draw_text(int x, const char *text, uint8_t red, uint8_t green, uint8_t blue) {
+    while (*text) {
+        uint32_t codepoint;
+        text = led_utf8_next(text, &codepoint);
+        x = led_draw_glyph(x, codepoint, red, green, blue);
+    }
+    return x;
+}
+
+void led_display_time(const struct tm *timeinfo, bool synced) {
+    char text[16];
+    snprintf(text, sizeof(text), "%02d:%02d:%02d", timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec);
+
+    LED_PROFILE_BEGIN(frame);
+    // 时钟只有两种颜色, 使用单色帧缓冲, 颜色由调色板的 0/1 两项决定
+    led_fb_set_format(LED_FB_FORMAT_MONO1);
+    led_fb_set_palette(0, 0, 0, 0);
+    if (synced) {
+        led_fb_set_palette(1, 255, 0, 0);
+    } else {
+        led_fb_set_palette(1, 255, 96, 0);
+    }
 
-    led_set_num_pixel(minute1, &index, 255, 0, 0, 1, led_is_reverse(index));
-    led_set_space(&index);
-    led_set_num_pixel(minute2, &index, 255, 0, 0, 1, led_is_reverse(index));
-    led_set_space(&index);
-    led_set_colon(&index, 255, 0, 0, 1, led_is_reverse(index));
-    led_set_space(&index);
+    // 先在帧缓冲中合成整帧, 最后只刷新一次灯带
+    LED_PROFILE_BEGIN(clear);
+    led_fb_clear();
+    LED_PROFILE_END(LED_PROFILE_COMPOSE, clear);
+    led_draw_text(2, text, 255, 0, 0);
 
-    led_set_num_pixel(second1, &index, 255, 0, 0, 1, led_is_reverse(index));
-    led_set_space(&index);
-    led_set_num_pixel(second2, &index, 255, 0, 0, 1, led_is_reverse(index));
-    led_set_space(&index);
+    if (led_frame_commit() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to commit frame");
+    }
+    // 抖动任务在 frame_lock 下更新统计, 在锁内复制一份再读
+    led_frame_stats_t stats;
+    led_get_frame_stats(&stats);
+    if (stats.last_frame_refreshes > 1) {
+        ESP_LOGW(TAG, "Frame %" PRIu32 " used %" PRIu32 " refreshes", stats.frames, stats.last_frame_refreshes);
+    }
+    LED_PROFILE_END(LED_PROFILE_FRAME, frame);
+    led_profile_frame_end();
+}
+
+// 频谱调色板: 0 为黑色, 每一行 LED_SPECTRUM_SHADES 级亮度, 最后一项为峰值点
+#define LED_SPECTRUM_SHADES 4
+#define LED_SPECTRUM_PEAK   (1 + PIXEL_HIGHT * LED_SPECTRUM_SHADES)
+
+void led_display_spectrum(const uint16_t *levels, const uint16_t *peaks, int bands) {
+    LED_PROFILE_BEGIN(frame);
+    led_fb_set_format(LED_FB_FORMAT_INDEXED8);
+    // 颜色从底部的绿色渐变到顶部的红色, 调色板没有变化时不会重新换算
+    led_fb_set_palette(0, 0, 0, 0);
+    for (int row = 0; row < PIXEL_HIGHT; row++) {
+        uint32_t t = row * 510 / (PIXEL_HIGHT - 1);
+        uint8_t red = t < 255 ? t : 255;
+        uint8_t green = t > 255 ? 510 - t : 255;
+        for (int shade = 1; shade <= LED_SPECTRUM_SHADES; shade++) {
+            led_fb_set_palette(1 + row * LED_SPECTRUM_SHADES + shade - 1, red * shade / LED_SPECTRUM_SHADES,
+                               green * shade / LED_SPECTRUM_SHADES, 0);
+        }
+    }
+    led_fb_set_palette(LED_SPECTRUM_PEAK, 255, 255, 255);
+
+    LED_PROFILE_BEGIN(compose);
+    led_fb_clear();
+    for (int x = 0; x < PIXEL_WIDTH; x++) {
+        int band = x * bands / PIXEL_WIDTH;
+        // 整像素部分全亮, 最上面不足一个像素的部分按比例调暗
+        uint32_t full = levels[band] / LED_SPECTRUM_ONE;
+        uint32_t shade = (levels[band] % LED_SPECTRUM_ONE) * LED_SPECTRUM_SHADES / LED_SPECTRUM_ONE;
+        for (uint32_t row = 0; row < PIXEL_HIGHT && row <= full; row++) {
+            uint32_t level = row < full ? LED_SPECTRUM_SHADES : shade;
+            if (level > 0) {
+                led_fb_set_index(x, PIXEL_HIGHT - 1 - row, 1 + row * LED_SPECTRUM_SHADES + level - 1);
+            }
+        }
+        if (peaks[band] > levels[band]) {
+            uint32_t row = (peaks[band] - 1) / LED_SPECTRUM_ONE;
+            led_fb_set_index(x, PIXEL_HIGHT - 1 - (row < PIXEL_HIGHT ? row : PIXEL_HIGHT - 1), LED_SPECTRUM_PEAK);
+        }
+    }
+    LED_PROFILE_END(LED_PROFILE_COMPOSE, compose);
+
+    if (led_frame_commit() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to commit frame");
+    }
+    LED_PROFILE_END(LED_PROFILE_FRAME, frame);
+    led_profile_frame_end();
 }
 
+void led_display_ambient(uint16_t bass, uint16_t mid, uint16_t treble) {
+    LED_PROFILE_BEGIN(frame);
+    // 整帧只用调色板的第 1 项, 颜色变化只需要修改调色板
+    led_fb_set_format(LED_FB_FORMAT_INDEXED8);
+    led_fb_set_palette(1, bass * 255 / LED_SPECTRUM_ONE, mid * 255 / LED_SPECTRUM_ONE, treble * 255 / LED_SPECTRUM_ONE);
+
+    LED_PROFILE_BEGIN(compose);
+    for (int y = 0; y < PIXEL_HIGHT; y++) {
+        for (int x = 0; x < PIXEL_WIDTH; x++) {
+            led_fb_set_index(x, y, 1);
+        }
+    }
+    LED_PROFILE_END(LED_PROFILE_COMPOSE, compose);
+
+    if (led_frame_commit() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to commit frame");
+    }
+    LED_PROFILE_END(LED_PROFILE_FRAME, frame);
+    led_profile_frame_end();
+}
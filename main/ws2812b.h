@@ -1,8 +1,8 @@
 #ifndef WS2812B_H
 #define WS2812B_H
 
-#include "driver/gpio.h"
 #include "led_strip.h"
+#include <stdbool.h>
 #include "time.h"
 
 
@@ -17,22 +17,89 @@
 // 10MHz resolution, 1 tick = 0.1us (led strip needs a high resolution)
 #define LED_STRIP_RMT_RES_HZ  (10 * 1000 * 1000)
 
-#define BRIGHTNESS_SCALE 0.01
+/**
+ * @brief Framebuffer pixel formats
+ */
+typedef enum {
+    LED_FB_FORMAT_RGB888,   /*!< 3 bytes per pixel, drawn with led_fb_set_pixel */
+    LED_FB_FORMAT_INDEXED8, /*!< 1 byte per pixel, an index into the 256-entry palette */
+    LED_FB_FORMAT_MONO1,    /*!< 1 bit per pixel, one 32-bit word per row with the leftmost column in bit 31. Bits select palette entries 0 and 1 */
+} led_fb_format_t;
+
+/**
+ * @brief Frame compositor statistics
+ */
+typedef struct {
+    uint32_t frames;                /*!< Frames committed since boot */
+    uint32_t transmitted;           /*!< Frames that differed from the last one sent and went out on the strip */
+    uint32_t skipped;               /*!< Frames identical to the last one sent after brightness scaling, no refresh issued */
+    uint32_t refreshes;             /*!< Strip refreshes issued since boot */
+    uint32_t last_frame_refreshes;  /*!< Strip refreshes issued from the previous commit through the last one, including clears and brightness changes but not dithering. 0 if skipped, otherwise expected to be 1 */
+    uint32_t dither_refreshes;      /*!< Strip refreshes issued by temporal dithering between committed frames */
+    uint32_t last_encode_cycles;    /*!< CPU cycles the RMT encoder spent pre-encoding the last transmitted frame */
+    uint32_t last_bytes_encoded;    /*!< Color bytes re-encoded for the last transmitted frame */
+} led_frame_stats_t;
 
 
 esp_err_t led_init();
 
 esp_err_t led_clear_all();
 
-bool led_is_reverse(int start_index);
+// 离屏帧缓冲, (0,0) 为左上角, 绘制完成后调用 led_frame_commit 一次性刷新到灯带
+// 与上一次发送的帧内容相同时不会刷新灯带
+// 选择绘制和提交使用的帧缓冲格式, 各格式的缓冲相互独立
+void led_fb_set_format(led_fb_format_t format);
 
-void led_set_num_pixel(int num,int *start_index, uint32_t red, uint32_t green, uint32_t blue, uint8_t brightness, bool reverse);
+led_fb_format_t led_fb_get_format();
 
-void led_set_colon(int *start_index, uint32_t red, uint32_t green, uint32_t blue, uint8_t brightness, bool reverse);
+// 清空当前格式的帧缓冲
+void led_fb_clear();
 
-void led_set_space(int *start_index);
+// RGB888 格式
+void led_fb_set_pixel(int x, int y, uint8_t red, uint8_t green, uint8_t blue);
 
-void led_display_time(const struct tm *timeinfo);
+// 调色板在提交时经 gamma 和亮度换算一次, 输出时每个像素只查一次表
+void led_fb_set_palette(uint8_t index, uint8_t red, uint8_t green, uint8_t blue);
+
+// INDEXED8 格式
+void led_fb_set_index(int x, int y, uint8_t index);
+
+// MONO1 格式, 可以直接对 led_fb_mono_rows 返回的 PIXEL_HIGHT 个字做位运算
+void led_fb_mono_set(int x, int y, bool on);
+
+uint32_t *led_fb_mono_rows();
+
+// 整帧水平移动, dx 为正时向左, 移出的列丢弃, 移入的列为 0
+void led_fb_mono_scroll(int dx);
+
+esp_err_t led_frame_commit();
+
+// 设置全局亮度 (0~100), 经 gamma 查找表换算, 立即作用于当前帧
+esp_err_t led_set_brightness(uint8_t percent);
+
+uint8_t led_get_brightness();
+
+void led_get_frame_stats(led_frame_stats_t *stats);
+
+// 从字模图集绘制一个字符, 返回下一个字符的起始列
+// 颜色为全亮度下的值, 输出时统一做 gamma 和亮度换算
+// INDEXED8 和 MONO1 格式忽略颜色参数, 笔画写入调色板第 1 项, 空白写入第 0 项
+int led_draw_glyph(int x, uint32_t codepoint, uint8_t red, uint8_t green, uint8_t blue);
+
+// 绘制 UTF-8 字符串, 返回下一个字符的起始列
+int led_draw_text(int x, const char *text, uint8_t red, uint8_t green, uint8_t blue);
+
+// 显示时间, 尚未对时的时间 (启动时从检查点恢复) 用琥珀色显示
+void led_display_time(const struct tm *timeinfo, bool synced);
+
+// 频谱柱高度的单位, 一个像素为 LED_SPECTRUM_ONE
+#define LED_SPECTRUM_ONE 256
+
+// 显示频谱, 每个频带一列, levels 和 peaks 为各频带的柱高和峰值, 单位为 1/LED_SPECTRUM_ONE 像素
+void led_display_spectrum(const uint16_t *levels, const uint16_t *peaks, int bands);
+
+// 环境模式: 整个面板显示一种颜色, 低音、中音、高音的电平 (0~LED_SPECTRUM_ONE) 分别控制红、绿、蓝
+void led_display_ambient(uint16_t bass, uint16_t mid, uint16_t treble);
 
 
 #endif // WS2812B_H
@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""Compile the glyphs designed in fonts.xlsx into a packed font atlas header.
+
+The sheet (or a CSV export of it) holds each glyph as a run of horizontally
+adjacent cells with its column bytes ("0x3E", "0x44", ...), most significant
+bit on the top row of the panel. The cell right below the run, in any of its
+columns, names the glyph:
+
+    a single character      the character itself, e.g. "7" or ":"
+    "space"                 U+0020
+    "U+XXXX"                any code point, e.g. "U+6642"
+
+A label may end with "|N" to override the blank columns drawn after the glyph
+(default --spacing). Pixel drawings in the sheet are only for the designer and
+are ignored.
+
+Usage: font_atlas.py fonts.xlsx -o font_atlas_data.h
+"""
+
+import argparse
+import csv
+import re
+import sys
+import xml.etree.ElementTree as ET
+import zipfile
+
+NS = {'m': 'http://schemas.openxmlformats.org/spreadsheetml/2006/main'}
+HEX_RE = re.compile(r'^0[xX][0-9a-fA-F]{1,2}$')
+CELL_RE = re.compile(r'^([A-Z]+)(\d+)$')
+
+
+def column_number(letters):
+    n = 0
+    for ch in letters:
+        n = n * 26 + ord(ch) - ord('A') + 1
+    return n
+
+
+def read_xlsx(path):
+    """Return {(row, col): text} for every non-empty cell of the first sheet."""
+    with zipfile.ZipFile(path) as z:
+        shared = []
+        if 'xl/sharedStrings.xml' in z.namelist():
+            root = ET.fromstring(z.read('xl/sharedStrings.xml'))
+            for si in root.findall('m:si', NS):
+                shared.append(''.join(t.text or '' for t in si.iter('{%s}t' % NS['m'])))
+        root = ET.fromstring(z.read('xl/worksheets/sheet1.xml'))
+    cells = {}
+    for c in root.iter('{%s}c' % NS['m']):
+        m = CELL_RE.match(c.get('r'))
+        row, col = int(m.group(2)), column_number(m.group(1))
+        kind = c.get('t')
+        if kind == 'inlineStr':
+            text = ''.join(t.text or '' for t in c.iter('{%s}t' % NS['m']))
+        else:
+            v = c.find('m:v', NS)
+            if v is None:
+                continue
+            text = shared[int(v.text)] if kind == 's' else v.text
+            # numeric labels come back as "1" or "1.0"
+            if kind is None and re.match(r'^\d+\.0$', text):
+                text = text[:-2]
+        if text.strip():
+            cells[(row, col)] = text.strip()
+    return cells
+
+
+def read_csv(path):
+    cells = {}
+    with open(path, newline='', encoding='utf-8-sig') as f:
+        for row, line in enumerate(csv.reader(f), start=1):
+            for col, text in enumerate(line, start=1):
+                if text.strip():
+                    cells[(row, col)] = text.strip()
+    return cells
+
+
+def parse_label(label, default_spacing):
+    spacing = default_spacing
+    if '|' in label and len(label) > 1:
+        label, spacing_text = label.rsplit('|', 1)
+        spacing = int(spacing_text)
+    if label == 'space':
+        return 0x20, spacing
+    if re.match(r'^U\+[0-9a-fA-F]{4,6}$', label):
+        return int(label[2:], 16), spacing
+    if len(label) == 1:
+        return ord(label), spacing
+    raise ValueError('unrecognised glyph label "%s"' % label)
+
+
+def extract_glyphs(cells, default_spacing):
+    glyphs = {}
+    for (row, col) in sorted(cells):
+        text = cells[(row, col)]
+        if not HEX_RE.match(text) or HEX_RE.match(cells.get((row, col - 1), '')):
+            continue
+        # start of a run of column bytes
+        columns = []
+        end = col
+        while HEX_RE.match(cells.get((row, end), '')):
+            columns.append(int(cells[(row, end)], 16))
+            end += 1
+        labels = [cells[(row + 1, c)] for c in range(col, end) if (row + 1, c) in cells]
+        labels = [l for l in labels if not HEX_RE.match(l)]
+        if len(labels) != 1:
+            raise ValueError('glyph at row %d, column %d needs exactly one label below it' % (row, col))
+        codepoint, spacing = parse_label(labels[0], default_spacing)
+        if codepoint in glyphs:
+            raise ValueError('glyph U+%04X defined twice' % codepoint)
+        glyphs[codepoint] = (columns, spacing)
+    return glyphs
+
+
+def glyph_comment(codepoint):
+    if 0x20 < codepoint < 0x7F and chr(codepoint) not in '\\':
+        return "'%s'" % chr(codepoint)
+    return 'U+%04X' % codepoint
+
+
+def write_header(glyphs, source, out):
+    columns = []
+    entries = []
+    for codepoint in sorted(glyphs):
+        data, spacing = glyphs[codepoint]
+        entries.append((codepoint, len(columns), len(data), spacing))
+        columns.extend(data)
+    if len(columns) > 0xFFFF:
+        raise ValueError('font atlas too large: %d columns' % len(columns))
+
+    ascii_index = [-1] * 128
+    for i, (codepoint, _, _, _) in enumerate(entries):
+        if codepoint < 128:
+            ascii_index[codepoint] = i
+
+    lines = []
+    lines.append('// Generated by tools/font_atlas.py from %s, do not edit' % source)
+    lines.append('#pragma once')
+    lines.append('')
+    lines.append('#define FONT_ATLAS_GLYPH_COUNT %d' % len(entries))
+    lines.append('')
+    lines.append('// 按列存储的字模, 每列一个字节, 最高位对应最上面一行')
+    lines.append('static const uint8_t font_atlas_columns[%d] = {' % max(len(columns), 1))
+    for codepoint, offset, width, _ in entries:
+        data = ', '.join('0x%02X' % b for b in columns[offset:offset + width])
+        lines.append('    %s, // %s' % (data, glyph_comment(codepoint)))
+    lines.append('};')
+    lines.append('')
+    lines.append('// 按码位排序, 便于二分查找')
+    lines.append('static const font_glyph_t font_atlas_glyphs[%d] = {' % max(len(entries), 1))
+    for codepoint, offset, width, spacing in entries:
+        lines.append('    {0x%04X, %d, %d, %d}, // %s' % (codepoint, offset, width, spacing, glyph_comment(codepoint)))
+    lines.append('};')
+    lines.append('')
+    lines.append('// ASCII 码位到 font_atlas_glyphs 下标, -1 表示没有该字模')
+    lines.append('static const int16_t font_atlas_ascii[128] = {')
+    for i in range(0, 128, 16):
+        lines.append('    %s,' % ', '.join('%d' % v for v in ascii_index[i:i + 16]))
+    lines.append('};')
+    lines.append('')
+    out.write('\n'.join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('source', help='fonts.xlsx or a CSV export of its sheet')
+    parser.add_argument('-o', '--output', required=True, help='generated header')
+    parser.add_argument('--spacing', type=int, default=1, help='blank columns after each glyph (default 1)')
+    args = parser.parse_args()
+
+    cells = read_csv(args.source) if args.source.lower().endswith('.csv') else read_xlsx(args.source)
+    try:
+        glyphs = extract_glyphs(cells, args.spacing)
+    except ValueError as e:
+        sys.exit('%s: %s' % (args.source, e))
+    if not glyphs:
+        sys.exit('%s: no glyphs found' % args.source)
+
+    source = args.source.replace('\\', '/').split('/')[-1]
+    with open(args.output, 'w', encoding='utf-8', newline='\n') as out:
+        write_header(glyphs, source, out)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""Local stand-in NTP servers with a known clock offset and injected delay.
+
+Each SPEC starts one server on 127.0.0.1 (or --bind):
+
+    PORT:OFFSET_MS[:DELAY_MS[:JITTER_MS]]
+
+The server's clock is the host clock plus OFFSET_MS. Every reply is held back
+by DELAY_MS plus a uniform random 0..JITTER_MS after the transmit timestamp is
+taken, as queueing on the return path would. A client on the same host should
+then measure an offset of OFFSET_MS - delay / 2 and a round-trip delay of
+about DELAY_MS. PORT 0 picks a free port.
+
+Once all sockets are bound the script prints "ready" and the bound ports on
+one line, then serves until it is killed.
+
+Usage: ntp_test_server.py 12301:500:20 12302:500:60 12303:2000
+"""
+
+import argparse
+import random
+import socket
+import struct
+import sys
+import threading
+import time
+
+NTP_UNIX_OFFSET = 2208988800
+NTP_PACKET_SIZE = 48
+# LI 0, version 4, mode 4 (server)
+NTP_HEADER = (0 << 6) | (4 << 3) | 4
+STRATUM = 2
+
+
+def parse_spec(text):
+    fields = text.split(':')
+    if not 2 <= len(fields) <= 4:
+        raise argparse.ArgumentTypeError('expected PORT:OFFSET_MS[:DELAY_MS[:JITTER_MS]], got %r' % text)
+    try:
+        port = int(fields[0])
+        values = [float(f) / 1000 for f in fields[1:]] + [0.0] * (4 - len(fields))
+    except ValueError:
+        raise argparse.ArgumentTypeError('invalid number in %r' % text)
+    return port, values[0], values[1], values[2]
+
+
+def ntp_timestamp(t):
+    sec = int(t)
+    return struct.pack('!II', (sec + NTP_UNIX_OFFSET) & 0xFFFFFFFF, int((t - sec) * 2**32) & 0xFFFFFFFF)
+
+
+def serve(sock, offset, delay, jitter):
+    while True:
+        request, addr = sock.recvfrom(512)
+        receive = time.time() + offset
+        if len(request) < NTP_PACKET_SIZE:
+            continue
+        reply = bytearray(NTP_PACKET_SIZE)
+        reply[0] = NTP_HEADER
+        reply[1] = STRATUM
+        reply[2] = request[2]       # poll
+        reply[3] = 0xEC             # precision 2^-20 s
+        reply[12:16] = b'LOCL'
+        reply[16:24] = ntp_timestamp(receive)
+        reply[24:32] = request[40:48]   # originate = the client's transmit timestamp
+        reply[32:40] = ntp_timestamp(receive)
+        reply[40:48] = ntp_timestamp(time.time() + offset)
+        time.sleep(delay + random.uniform(0, jitter))
+        sock.sendto(bytes(reply), addr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('specs', nargs='+', type=parse_spec, metavar='SPEC',
+                        help='PORT:OFFSET_MS[:DELAY_MS[:JITTER_MS]]')
+    parser.add_argument('--bind', default='127.0.0.1', help='address to listen on (default 127.0.0.1)')
+    args = parser.parse_args()
+
+    ports = []
+    for port, offset, delay, jitter in args.specs:
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        sock.bind((args.bind, port))
+        ports.append(sock.getsockname()[1])
+        threading.Thread(target=serve, args=(sock, offset, delay, jitter), daemon=True).start()
+    print('ready', *ports, flush=True)
+    try:
+        while True:
+            time.sleep(3600)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())